@@ -8,6 +8,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Config {
 public:
@@ -23,12 +24,36 @@ public:
     int getPostgresPort() const { return port_; }
     std::string getPostgresSchema() const { return schema_; }
     std::string getPostgresTable() const { return table_; }
+    int getIndexWorkers() const { return index_workers_; }
+    std::string getPostgresPartitioning() const { return partitioning_; }
+    std::string getPostgresColumnProfile() const { return column_profile_; }
+    int getLockWaitSeconds() const { return lock_wait_seconds_; }
     
     // arXiv configuration
+    std::string getArxivBaseUrl() const { return base_url_; }
+    std::string getRepositoriesFile() const { return repositories_file_; }
     int getRateLimitDelay() const { return rate_limit_delay_; }
     int getBatchSize() const { return batch_size_; }
     int getMaxRetries() const { return max_retries_; }
+    int getMaxInflight() const { return max_inflight_; }
     int getRetryAfter() const { return retry_after_; }
+    int getBackfillTargetPages() const { return backfill_target_pages_; }
+    std::string getCheckpointFile() const { return checkpoint_file_; }
+    std::string getArchiveDir() const { return archive_dir_; }
+    int getLoadParsers() const { return load_parsers_; }
+    int getLoadConnections() const { return load_connections_; }
+    
+    // Record sinks (RECORD_SINKS, comma-separated)
+    std::vector<std::string> getRecordSinks() const { return record_sinks_; }
+    
+    // Job queue configuration
+    std::string getWorkerId() const { return worker_id_; }
+    int getJobLeaseSeconds() const { return job_lease_seconds_; }
+    int getJobMaxAttempts() const { return job_max_attempts_; }
+    
+    // Daemon configuration
+    std::string getDaemonRecentTime() const { return daemon_recent_time_; }
+    int getDaemonRetryDelay() const { return daemon_retry_delay_; }
     
     // Docker configuration
     std::string getDockerPostgresHost() const { return docker_host_; }
@@ -51,12 +76,30 @@ private:
     int port_;
     std::string schema_;
     std::string table_;
+    int index_workers_;
+    std::string partitioning_;
+    std::string column_profile_;
+    int lock_wait_seconds_;
     
     // arXiv settings
+    std::string base_url_;
+    std::string repositories_file_;
     int rate_limit_delay_;
     int batch_size_;
     int max_retries_;
+    int max_inflight_;
     int retry_after_;
+    int backfill_target_pages_;
+    std::string checkpoint_file_;
+    std::string archive_dir_;
+    int load_parsers_;
+    int load_connections_;
+    std::vector<std::string> record_sinks_;
+    std::string worker_id_;
+    int job_lease_seconds_;
+    int job_max_attempts_;
+    std::string daemon_recent_time_;
+    int daemon_retry_delay_;
     
     // Docker settings
     std::string docker_host_;
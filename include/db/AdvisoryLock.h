@@ -0,0 +1,46 @@
+/**
+ * @file AdvisoryLock.h
+ * @brief Session advisory locks that keep overlapping runs off the same sets
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <set>
+#include <string>
+#include "Database.h"
+
+struct LockStats {
+    long acquired = 0;
+    long skipped = 0;       // held by another session for the whole wait
+    long waited_ms = 0;
+};
+
+class AdvisoryLocks {
+public:
+    AdvisoryLocks(Database& db);
+    
+    // pg_try_advisory_lock on the key's hash, retried once a second for up
+    // to `wait_seconds`. The lock belongs to the session, so a crashed run
+    // releases it with its connection.
+    bool tryLock(const std::string& key, int wait_seconds);
+    void unlockAll();
+    
+    const LockStats& stats() const { return stats_; }
+    
+    // Releases every lock when the scope ends, including on exceptions
+    class Release {
+    public:
+        explicit Release(AdvisoryLocks& locks) : locks_(locks) {}
+        ~Release();
+        Release(const Release&) = delete;
+        Release& operator=(const Release&) = delete;
+    private:
+        AdvisoryLocks& locks_;
+    };
+    
+private:
+    Database& db_;
+    std::set<std::string> held_;
+    LockStats stats_;
+};
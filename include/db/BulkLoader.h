@@ -0,0 +1,83 @@
+/**
+ * @file BulkLoader.h
+ * @brief Parallel COPY into staging tables with a single set-based merge
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../utils/BoundedQueue.h"
+#include "Database.h"
+
+// Throughput of one stage of a bulk load
+struct LoadStage {
+    std::string name;
+    long records = 0;
+    long bytes = 0;
+    double seconds = 0;
+};
+
+// Producers hand over finished binary COPY streams (RecordTable rows); each
+// of `connections` threads streams them into its own unlogged staging table.
+// finish() merges all staging tables into the target in one transaction.
+class BulkLoader {
+public:
+    BulkLoader(std::string schema_name, std::string table_name, PartitionScheme scheme,
+               int connections);
+    // Stops the copy threads and drops the staging tables
+    ~BulkLoader();
+    BulkLoader(const BulkLoader&) = delete;
+    BulkLoader& operator=(const BulkLoader&) = delete;
+    
+    // Creates the staging tables and starts the copy threads
+    void start();
+    
+    // Blocks while every connection already has streams waiting. Thread-safe.
+    void submit(std::string data, long rows);
+    
+    // Waits for the copies, then upserts the staged rows on `db` and runs
+    // `in_transaction` before the commit. Throws if any copy failed.
+    void finish(Database& db, const std::function<void()>& in_transaction = {});
+    
+    long copiedRows() const { return copied_rows_; }
+    long copiedBytes() const { return copied_bytes_; }
+    double copySeconds() const { return copy_seconds_; }
+    double mergeSeconds() const { return merge_seconds_; }
+    
+    // Records/s (and MB/s where bytes were counted) of each stage
+    static void logStages(const std::vector<LoadStage>& stages);
+    
+private:
+    struct Stream {
+        std::string data;
+        long rows = 0;
+    };
+    
+    void copyWorker(size_t index);
+    void stop();
+    std::string stagingTable(size_t index) const;
+    
+    std::string schema_;
+    std::string table_;
+    PartitionScheme scheme_;
+    std::vector<std::unique_ptr<Database>> connections_;
+    std::vector<std::thread> threads_;
+    BoundedQueue<Stream> queue_;
+    std::chrono::steady_clock::time_point started_;
+    
+    std::atomic<long> copied_rows_;
+    std::atomic<long> copied_bytes_;
+    double copy_seconds_;
+    double merge_seconds_;
+    
+    std::mutex error_mutex_;
+    std::string error_;
+};
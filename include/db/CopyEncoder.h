@@ -0,0 +1,46 @@
+/**
+ * @file CopyEncoder.h
+ * @brief Encoder for PostgreSQL binary COPY streams
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CopyEncoder {
+public:
+    CopyEncoder();
+    
+    // Reset to an empty stream (header only), keeping the allocated buffer
+    void clear();
+    
+    // Row and field encoding, in table column order
+    void beginRow(int16_t field_count);
+    void addNull();
+    void addText(std::string_view value);
+    void addTimestamp(std::string_view datestamp);
+    void addTextArray(const std::vector<std::string>& values);
+    void addJsonb(std::string_view json_text);
+    void addJsonbArray(const std::vector<std::string>& values);
+    
+    // Append the trailer; the stream is complete after this call
+    void finish();
+    
+    const std::string& data() const { return buffer_; }
+    // Hand the stream over without a copy and start an empty one
+    std::string take();
+    size_t rows() const { return rows_; }
+    
+private:
+    std::string buffer_;
+    size_t rows_;
+    
+    void putInt16(int16_t value);
+    void putInt32(int32_t value);
+    void putInt64(int64_t value);
+    void patchInt32(size_t pos, int32_t value);
+};
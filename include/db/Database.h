@@ -8,29 +8,79 @@
 
 #include <string>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 #include <libpq-fe.h>
 
+// Range partitioning of the metadata table on header_datestamp
+enum class PartitionScheme { None, Yearly, Monthly };
+
+// Storage type of the multi-valued columns (header_setSpecs, metadata_creator, ...)
+enum class ColumnProfile { Jsonb, TextArray };
+
 class Database {
 public:
     Database();
     ~Database();
     
     void connect();
+    // A libpq connection string or postgresql:// URL instead of the config
+    void connect(const std::string& conninfo);
     void disconnect();
     bool isConnected() const;
+    // Re-establish a dropped connection; session state (temp tables,
+    // SET options) does not survive the reset
+    void ensureConnected();
     
     PGconn* getConnection() { return conn_; }
     
     // Schema and table operations
     void createSchema(const std::string& schema_name);
-    void createTable(const std::string& schema_name, const std::string& table_name);
+    void createTable(const std::string& schema_name, const std::string& table_name,
+                     PartitionScheme scheme = PartitionScheme::None,
+                     ColumnProfile profile = ColumnProfile::Jsonb);
     void createIndexes(const std::string& schema_name, const std::string& table_name);
     
+    // Bulk-load support: drop the secondary indexes before a large load and
+    // rebuild them afterwards on parallel connections, finishing with ANALYZE
+    void dropSecondaryIndexes(const std::string& schema_name, const std::string& table_name);
+    void buildIndexesParallel(const std::string& schema_name, const std::string& table_name,
+                              int workers);
+    
+    // Partition operations
+    static PartitionScheme parsePartitionScheme(const std::string& value);
+    bool isPartitioned(const std::string& schema_name, const std::string& table_name);
+    bool tableExists(const std::string& schema_name, const std::string& table_name);
+    void ensurePartitions(const std::string& schema_name, const std::string& table_name,
+                          PartitionScheme scheme, const std::vector<std::string>& datestamps);
+    void freezePartitionsBefore(const std::string& schema_name, const std::string& table_name,
+                                const std::string& cutoff_date);
+    
+    // Column profile operations
+    static ColumnProfile parseColumnProfile(const std::string& value);
+    ColumnProfile columnProfile(const std::string& schema_name, const std::string& table_name);
+    
+    // SQL predicate matching rows in a set: the set itself or any of its
+    // subsets ("cs" matches "cs" and "cs:cs:AI"); `param` is a placeholder
+    static std::string setSpecMatch(ColumnProfile profile, const std::string& param);
+    
     // Query operations
     void execute(const std::string& query);
+    void execute(const std::string& query, const std::vector<const char*>& params);
     PGresult* query(const std::string& query);
+    PGresult* query(const std::string& query, const std::vector<const char*>& params);
+    
+    // Stream a complete COPY ... FROM STDIN payload
+    void copyFrom(const std::string& copy_query, const std::string& data);
     
 private:
     PGconn* conn_;
     bool connected_;
+    std::set<std::string> known_partitions_;
+    
+    // Secondary indexes as (name, definition) pairs; the header_identifier
+    // index comes from the UNIQUE constraint and is not part of this list
+    static std::vector<std::pair<std::string, std::string>> secondaryIndexes(
+        const std::string& schema_name, const std::string& table_name);
 };
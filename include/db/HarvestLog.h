@@ -0,0 +1,60 @@
+/**
+ * @file HarvestLog.h
+ * @brief Per-set, per-day harvest coverage ledger
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include "Database.h"
+
+// Outcome of one harvested (set, from, until) window
+struct HarvestWindow {
+    std::string set_spec;
+    std::string from_date;
+    std::string until_date;
+    std::map<std::string, int> day_counts;  // YYYY-MM-DD -> records
+    // Set-less windows only: day counts for each configured set
+    std::map<std::string, std::map<std::string, int>> set_day_counts;
+    int pages = 0;
+    int page_size = 0;              // records on a full page; 0 if one page
+    long complete_list_size = -1;
+};
+
+class HarvestLog {
+public:
+    HarvestLog(Database& db);
+    
+    // `prefix` keeps ledgers of repositories sharing a schema apart
+    void ensureTable(const std::string& schema_name, const std::string& prefix = "");
+    // Names the table without creating it, for read-only callers
+    void useTable(const std::string& schema_name, const std::string& prefix = "");
+    
+    // One row per day of the window; page and list-size figures describe the
+    // whole window, which is stored alongside as window_start/window_end
+    void recordComplete(const HarvestWindow& window);
+    // Marks the window's days 'running' before its first page is written,
+    // so a window that never completes leaves them uncovered even though
+    // its committed pages put rows in those days. Completed days keep their
+    // status in both calls.
+    void recordStarted(const std::string& set_spec, const std::string& from_date,
+                       const std::string& until_date);
+    void recordFailed(const std::string& set_spec, const std::string& from_date,
+                      const std::string& until_date);
+    
+    // True when every day of [from_date, until_date] was completed at or
+    // after `since` (an ISO 8601 timestamp)
+    bool coveredSince(const std::string& set_spec, const std::string& from_date,
+                      const std::string& until_date, const std::string& since);
+    
+    const std::string& tableName() const { return table_; }
+    
+private:
+    Database& db_;
+    std::string table_;
+    
+    void recordStatus(const std::string& set_spec, const std::string& from_date,
+                      const std::string& until_date, const char* status);
+};
@@ -0,0 +1,61 @@
+/**
+ * @file JobQueue.h
+ * @brief Shared queue of harvest windows for multi-node workers
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include "Database.h"
+
+// One (repository, set, window) unit of work
+struct HarvestJob {
+    long id = 0;
+    std::string repository;
+    std::string set_spec;           // empty for the set-less lane
+    std::string from_date;
+    std::string until_date;
+    int attempts = 0;
+};
+
+class JobQueue {
+public:
+    JobQueue(Database& db);
+    
+    void ensureTable(const std::string& schema_name);
+    
+    // Adds a pending job unless an unfinished job of the same repository and
+    // set already overlaps the window; returns whether one was added
+    bool enqueue(const std::string& repository, const std::string& set_spec,
+                 const std::string& from_date, const std::string& until_date);
+    
+    // Claims the oldest pending job, or a running one whose lease expired,
+    // with FOR UPDATE SKIP LOCKED so concurrent workers never get the same
+    // row. Expired jobs that used up max_attempts are marked failed first.
+    std::optional<HarvestJob> claim(const std::string& repository, const std::string& worker,
+                                    int lease_seconds, int max_attempts);
+    
+    // Extends the lease; false means the lease was lost to another worker
+    bool heartbeat(long id, const std::string& worker, int lease_seconds);
+    
+    void complete(long id, const std::string& worker);
+    // Back to pending, or to failed once attempts reach max_attempts
+    void fail(long id, const std::string& worker, const std::string& error, int max_attempts);
+    // Back to pending without using up an attempt (clean shutdown)
+    void release(long id, const std::string& worker);
+    
+    // Jobs per status for the repository
+    std::map<std::string, long> counts(const std::string& repository);
+    
+    // HARVEST_WORKER_ID if set, otherwise host:pid
+    static std::string defaultWorkerId();
+    
+    const std::string& tableName() const { return table_; }
+    
+private:
+    Database& db_;
+    std::string table_;
+};
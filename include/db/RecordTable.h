@@ -0,0 +1,29 @@
+/**
+ * @file RecordTable.h
+ * @brief Row layout and upsert of the metadata table
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include "../oai/Record.h"
+#include "CopyEncoder.h"
+#include "Database.h"
+
+// Shared by the harvester's per-batch path and the parallel archive loader,
+// so both write the same rows and resolve conflicts the same way
+class RecordTable {
+public:
+    // Loaded columns, in COPY order
+    static const std::string& columns();
+    
+    // One binary COPY row of `record` in the table's column profile
+    static void encode(CopyEncoder& encoder, const Record& record, ColumnProfile profile);
+    
+    // Upserts every row of `source` (same columns) into `target`, newest
+    // datestamp first when an identifier repeats. On a partitioned table a
+    // changed datestamp moves the row, keeping its created_at.
+    static std::string mergeQuery(const std::string& target, const std::string& source,
+                                  PartitionScheme scheme);
+};
@@ -0,0 +1,32 @@
+/**
+ * @file Watermark.h
+ * @brief Per-set high-water marks for incremental harvesting
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Database.h"
+
+class Watermarks {
+public:
+    Watermarks(Database& db);
+    
+    void ensureTable(const std::string& schema_name, const std::string& prefix = "");
+    
+    // Last day (YYYY-MM-DD) through which the set is fully committed, or an
+    // empty string if the set has never been harvested incrementally
+    std::string get(const std::string& set_spec);
+    
+    // Moves the marks forward, never back. Runs on the caller's connection,
+    // so inside an open transaction it commits or rolls back with the data.
+    void advance(const std::vector<std::string>& set_specs, const std::string& day);
+    
+    const std::string& tableName() const { return table_; }
+    
+private:
+    Database& db_;
+    std::string table_;
+};
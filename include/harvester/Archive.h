@@ -0,0 +1,66 @@
+/**
+ * @file Archive.h
+ * @brief On-disk archive of raw OAI-PMH response pages
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// One archived (repository, set, month) window. Its directory holds
+// page-00001.xml, page-00002.xml, ... as served, plus manifest.json.
+struct ArchiveWindow {
+    std::string repository;
+    std::string set_spec;           // empty for the set-less lane
+    std::string from_date;
+    std::string until_date;
+    int pages = 0;
+    long records = 0;
+    long complete_list_size = -1;
+    std::string fetched_at;         // UTC, ISO 8601
+    std::string path;
+    
+    std::vector<std::string> pageFiles() const;
+};
+
+// Layout: <root>/<repository>/<set or _all>/<YYYY-MM>/. A window only
+// appears once it is complete; pages are staged next to it and moved into
+// place with the manifest, so readers never see half a window.
+class PageArchive {
+public:
+    explicit PageArchive(std::string root);
+    
+    std::optional<ArchiveWindow> find(const std::string& repository, const std::string& set_spec,
+                                      const std::string& month) const;
+    // Every complete window of the repository, by set and month
+    std::vector<ArchiveWindow> list(const std::string& repository) const;
+    
+    class Writer {
+    public:
+        Writer(const PageArchive& archive, ArchiveWindow window);
+        ~Writer();
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        
+        void addPage(const std::string& xml, long records);
+        // Replaces any older copy of the window
+        void commit(long complete_list_size);
+        
+    private:
+        ArchiveWindow window_;
+        std::string staging_;
+        bool committed_;
+    };
+    
+    const std::string& root() const { return root_; }
+    
+private:
+    std::string windowPath(const std::string& repository, const std::string& set_spec,
+                           const std::string& month) const;
+    static std::optional<ArchiveWindow> readManifest(const std::string& path);
+    
+    std::string root_;
+};
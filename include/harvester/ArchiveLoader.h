@@ -0,0 +1,74 @@
+/**
+ * @file ArchiveLoader.h
+ * @brief Parallel bulk load of the raw page archive
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../db/BulkLoader.h"
+#include "../db/CopyEncoder.h"
+#include "../db/Database.h"
+#include "../db/HarvestLog.h"
+#include "Archive.h"
+#include "Repository.h"
+
+// Loads archived windows in three overlapping stages: `parsers` threads map
+// and parse page files and encode COPY rows, `connections` threads stream
+// them into staging tables, and one set-based merge upserts the lot and
+// writes the ledger in the same transaction
+class ArchiveLoader {
+public:
+    ArchiveLoader(Database& db, const Repository& repository, HarvestLog& harvest_log,
+                  ColumnProfile profile, PartitionScheme scheme);
+    
+    void setParsers(int parsers);
+    void setConnections(int connections);
+    void setInterrupt(std::function<bool()> interrupt) { interrupt_ = std::move(interrupt); }
+    
+    // Windows of `set_specs` whose days the ledger already has as complete
+    // since the archive copy was fetched are skipped. Returns the records
+    // loaded.
+    long run(const std::string& archive_dir, const std::vector<std::string>& set_specs);
+    
+    const std::vector<LoadStage>& stages() const { return stages_; }
+    
+private:
+    struct WindowLoad {
+        ArchiveWindow archived;
+        std::vector<std::string> files;
+        std::vector<std::string> route_sets;  // set-less: sets records are kept for
+        HarvestWindow ledger;
+        size_t pages_parsed = 0;
+        long dropped = 0;
+        bool failed = false;
+    };
+    
+    struct PageRef {
+        size_t window;
+        size_t page;
+    };
+    
+    void parseWorker(std::vector<WindowLoad>& windows, const std::vector<PageRef>& pages,
+                     BulkLoader& bulk, LoadStage& parsed);
+    void recordLedger(const std::vector<WindowLoad>& windows);
+    bool interrupted() const { return interrupt_ && interrupt_(); }
+    
+    Database& db_;
+    Repository repository_;
+    HarvestLog& harvest_log_;
+    ColumnProfile profile_;
+    PartitionScheme scheme_;
+    int parsers_;
+    int connections_;
+    std::function<bool()> interrupt_;
+    
+    std::atomic<size_t> next_page_;
+    std::mutex mutex_;
+    std::vector<LoadStage> stages_;
+};
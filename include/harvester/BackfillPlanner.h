@@ -0,0 +1,88 @@
+/**
+ * @file BackfillPlanner.h
+ * @brief Turns missing days into harvest windows for backfill
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Inclusive [from_date, until_date] window, dates as YYYY-MM-DD
+struct DateRange {
+    std::string from_date;
+    std::string until_date;
+    int days;
+    long estimated_records = 0;
+};
+
+// Dry-run description of one lane's backfill
+struct LanePlan {
+    std::string set_spec;               // empty for the set-less lane
+    long missing_days = 0;
+    std::vector<DateRange> gaps;        // runs of consecutive missing days
+    std::vector<DateRange> windows;     // ListRecords streams to be issued
+    std::vector<long> window_pages;
+    long estimated_records = 0;
+    long requests = 0;
+};
+
+struct BackfillPlan {
+    std::string start_date;
+    std::string end_date;
+    int page_size = 0;
+    int rate_limit_delay = 0;
+    std::vector<LanePlan> lanes;
+    
+    // Projections use fixed per-record and per-response figures, which are
+    // reported alongside the numbers in the JSON
+    long bytesFor(const LanePlan& lane) const;
+    long secondsFor(const LanePlan& lane) const;
+    
+    std::string toJson() const;
+    void log() const;
+};
+
+class BackfillPlanner {
+public:
+    BackfillPlanner(int page_size, int target_pages);
+    
+    // Merge sorted missing days into maximal runs of consecutive days. Each
+    // run is harvested as one ListRecords stream, so pages come back full
+    // instead of one short page per day.
+    static std::vector<DateRange> coalesce(const std::vector<std::string>& days);
+    
+    // Volume-aware windows: starting at missing_days[next], build the next
+    // window of roughly target_pages full pages. Short gaps of covered days
+    // are bridged when that saves a request. Advances `next` past the days
+    // the window covers.
+    DateRange nextWindow(const std::vector<std::string>& missing_days, size_t& next) const;
+    
+    // Feed back what the server reported so later windows are sized better
+    void addDayCount(const std::string& day, long count);
+    void observePageSize(int page_size);
+    void observeWindow(const DateRange& window, long complete_list_size);
+    
+    double estimateDay(long day_number) const;
+    int pageSize() const { return page_size_; }
+    long pagesFor(double records) const;
+    
+    // Date helpers; days are counted from 1970-01-01
+    static long toDayNumber(const std::string& date);
+    static std::string fromDayNumber(long day_number);
+    
+    // Backfill range with defaults: 2007-01-01 through yesterday
+    static std::pair<std::string, std::string> resolveRange(const std::string& start_date,
+                                                            const std::string& end_date);
+    // Calendar months overlapping [start, end], clipped to the range
+    static std::vector<DateRange> monthlyWindows(const std::string& start, const std::string& end);
+    
+private:
+    int page_size_;
+    int target_pages_;
+    std::map<long, long> known_counts_;
+    double unknown_scale_;
+};
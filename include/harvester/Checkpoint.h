@@ -0,0 +1,74 @@
+/**
+ * @file Checkpoint.h
+ * @brief Durable per-lane harvest checkpoints for crash-safe resume
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include "../db/Database.h"
+#include "../db/HarvestLog.h"
+
+// Progress through one window, saved after every committed page. A lane is
+// a set spec, or "*" for the set-less lane.
+struct Checkpoint {
+    std::string lane;
+    HarvestWindow window;           // pages, list size and counts so far
+    std::string resumption_token;
+    std::string token_expiration;   // UTC ISO 8601, empty if not reported
+    
+    // True if the server-reported expiry has passed
+    bool tokenExpired() const;
+    
+    // Checkpoint key for a set spec; the set-less lane is "*"
+    static std::string laneFor(const std::string& set_spec);
+};
+
+class CheckpointStore {
+public:
+    virtual ~CheckpointStore() = default;
+    
+    virtual std::optional<Checkpoint> load(const std::string& lane) = 0;
+    virtual void save(const Checkpoint& checkpoint) = 0;
+    virtual void clear(const std::string& lane) = 0;
+    
+    // A local file when `file_path` is set, otherwise a table in
+    // `schema_name`; `prefix` goes in front of the table or file name
+    static std::unique_ptr<CheckpointStore> create(Database& db,
+                                                   const std::string& schema_name,
+                                                   const std::string& file_path,
+                                                   const std::string& prefix = "");
+};
+
+class PostgresCheckpointStore : public CheckpointStore {
+public:
+    PostgresCheckpointStore(Database& db, const std::string& schema_name,
+                            const std::string& prefix = "");
+    
+    std::optional<Checkpoint> load(const std::string& lane) override;
+    void save(const Checkpoint& checkpoint) override;
+    void clear(const std::string& lane) override;
+    
+private:
+    Database& db_;
+    std::string table_;
+};
+
+class FileCheckpointStore : public CheckpointStore {
+public:
+    explicit FileCheckpointStore(const std::string& file_path);
+    
+    std::optional<Checkpoint> load(const std::string& lane) override;
+    void save(const Checkpoint& checkpoint) override;
+    void clear(const std::string& lane) override;
+    
+private:
+    std::string file_path_;
+    
+    // Replace the file atomically: write a sibling, fsync, rename
+    void writeAll(const std::string& contents);
+    std::string readAll();
+};
@@ -0,0 +1,46 @@
+/**
+ * @file Daemon.h
+ * @brief Long-running harvest loop with an internal daily schedule
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../db/Database.h"
+#include "Harvester.h"
+
+class Daemon {
+public:
+    using Clock = std::chrono::system_clock;
+    
+    Daemon(Database& db, Harvester& harvester, const std::vector<std::string>& set_specs);
+    
+    // Backfill range worked on while no recent harvest is due; an empty end
+    // date follows the calendar (yesterday at each pass)
+    void setBackfillRange(const std::string& start_date, const std::string& end_date);
+    
+    // Runs until SIGTERM or SIGINT; returns the records harvested
+    int run();
+    
+    static void installSignalHandlers();
+    static bool stopRequested();
+    
+private:
+    Database& db_;
+    Harvester& harvester_;
+    std::vector<std::string> set_specs_;
+    std::string backfill_start_;
+    std::string backfill_end_;
+    int recent_minute_;             // minutes after 00:00 UTC
+    int retry_delay_;
+    
+    // Next daily recent-harvest slot strictly after `after`
+    Clock::time_point nextRecentSlot(Clock::time_point after) const;
+    // Sleeps in short steps; returns false if a stop was requested
+    bool sleepUntil(Clock::time_point deadline) const;
+    
+    static int parseTimeOfDay(const std::string& value);
+};
@@ -6,31 +6,247 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
+#include "../db/AdvisoryLock.h"
 #include "../db/Database.h"
+#include "../db/HarvestLog.h"
+#include "../db/JobQueue.h"
+#include "../db/Watermark.h"
 #include "../oai/OaiClient.h"
+#include "../sink/RecordSink.h"
+#include "BackfillPlanner.h"
+#include "Checkpoint.h"
+#include "Repository.h"
+#include "RequestScheduler.h"
+
+// Thrown when the interrupt predicate fires between pages; the window keeps
+// its checkpoint and is resumed by the next backfill
+class HarvestInterrupted : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
 
 class Harvester {
 public:
+    // The repository described by the environment (arXiv by default)
     Harvester(Database& db);
+    Harvester(Database& db, const Repository& repository);
     ~Harvester();
     
     // Harvest operations
     int harvestRecent(const std::vector<std::string>& set_specs);
     int harvestBackfill(const std::string& start_date, const std::string& end_date, 
                        const std::vector<std::string>& set_specs);
+    // Recent windows and backfill through one request queue: recent pages
+    // first, then open resumption chains, then new backfill windows
+    int harvestRecentAndBackfill(const std::string& start_date, const std::string& end_date,
+                                 const std::vector<std::string>& set_specs);
+    // From each set's high-water mark to today (UTC); the mark advances to
+    // yesterday once the window's last page is flushed to every sink
+    int harvestIncremental(const std::vector<std::string>& set_specs);
+    
+    // Compare each (set, month) with the upstream completeListSize, one
+    // ListIdentifiers request per window, and re-harvest the ones that differ
+    int verifyCompleteness(const std::string& start_date, const std::string& end_date,
+                           const std::vector<std::string>& set_specs);
+    
+    // Multi-node backfill: the planned windows go into the shared
+    // harvest_jobs queue (returns the jobs added), and any number of workers
+    // on any host claim and harvest them until the queue is empty
+    int enqueueBackfill(const std::string& start_date, const std::string& end_date,
+                        const std::vector<std::string>& set_specs);
+    int harvestJobs(const std::vector<std::string>& set_specs);
+    
+    // Ingests the windows that --mode mirror wrote to the page archive
+    // without any upstream request, through the parallel ArchiveLoader. A
+    // window is skipped when the ledger has all its days completed after the
+    // archive copy was fetched.
+    int loadArchive(const std::string& archive_dir, const std::vector<std::string>& set_specs);
+    
+    // Bootstraps the table from the arXiv metadata JSON-lines snapshot and
+    // moves the ledger and watermarks up to it (see SnapshotImporter)
+    int importSnapshot(const std::string& path, const std::vector<std::string>& set_specs);
+    
+    // Dry run of harvestBackfill: the windows it would fetch and their
+    // estimated cost, read from the database without changing it
+    BackfillPlan planBackfill(const std::string& start_date, const std::string& end_date,
+                              const std::vector<std::string>& set_specs);
+    
+    // Bulk-load mode: secondary indexes are dropped before loading and
+    // rebuilt by finishBulkLoad() once all harvests are done
+    void setBulkLoad(bool enabled) { bulk_load_ = enabled; }
+    void finishBulkLoad();
+    
+    // Set-less mode: harvest each window once without a set parameter and
+    // route records to the configured sets by their header setSpecs, so
+    // cross-listed papers are downloaded and written only once
+    void setSetless(bool enabled) { setless_ = enabled; }
+    
+    // Where harvested records go, as RECORD_SINKS entries (see makeSink);
+    // several entries are written in parallel through a FanOutSink. The
+    // ledger, checkpoints and watermarks stay in Postgres, so postgres must
+    // be one of them.
+    void setSinks(std::vector<std::string> specs) { sink_specs_ = std::move(specs); }
+    
+    // Freeze partitions that end on or before the cutoff date
+    void freezePartitions(const std::string& cutoff_date);
+    
+    // Sets skipped because another run held their lock, and time spent
+    // waiting for locks (LOCK_WAIT_SECONDS)
+    const LockStats& lockStats() const { return locks_.stats(); }
+    
+    // Polled before every follow-up page and backfill window; when it
+    // returns true the harvest stops early and returns what it committed
+    void setInterrupt(std::function<bool()> interrupt) { interrupt_ = std::move(interrupt); }
     
 private:
+    // One window in progress, advanced a page at a time by stepWindow()
+    struct WindowJob {
+        std::string set_spec;                 // request set; empty when set-less
+        std::vector<std::string> route_sets;  // set-less: sets records are kept for
+        std::string label;
+        std::string lane;                     // checkpoint key
+        bool checkpointed = true;
+        HarvestWindow window;
+        std::optional<Checkpoint> resume;
+        std::string watermark;
+        bool watermark_done = true;
+        std::string final_until;              // later days stay 'running'
+        std::string next_token;
+        int total_records = 0;
+        long dropped = 0;
+        std::map<std::string, int> dropped_day_counts;
+        int result = 0;                       // records, or -1 if the window failed
+        std::string error;
+    };
+    
+    // Verification results shared by the probe tasks
+    struct VerifyState {
+        std::vector<std::pair<std::string, DateRange>> mismatches;
+        int checked = 0;
+        int unknown = 0;
+        int ahead = 0;     // more rows locally than upstream lists
+    };
+    
+    // Backfill state of one lane between its windows
+    struct BackfillLane {
+        BackfillLane(const std::string& lane, const std::string& start,
+                     const std::string& end, const BackfillPlanner& planner)
+            : lane(lane), label(lane.empty() ? "all sets" : lane),
+              start(start), end(end), planner(planner) {}
+        
+        std::string lane;
+        std::string label;
+        std::string start;
+        std::string end;
+        BackfillPlanner planner;
+        bool resume_checked = false;
+        bool loaded = false;
+        std::vector<std::string> missing_dates;
+        size_t next = 0;
+    };
+    
     Database& db_;
+    Repository repository_;
     OaiClient* oai_client_;
+    bool bulk_load_;
+    bool setless_;
+    PartitionScheme partitioning_;
+    ColumnProfile column_profile_;
+    std::vector<std::string> sink_specs_;
+    std::unique_ptr<RecordSink> sink_;
+    HarvestLog harvest_log_;
+    Watermarks watermarks_;
+    JobQueue jobs_;
+    AdvisoryLocks locks_;
+    std::unique_ptr<CheckpointStore> checkpoints_;
+    std::function<bool()> interrupt_;
+    bool schema_ready_;
     
     // Helper methods
     void ensureTableExists();
+    // Read-only part of ensureTableExists: names the ledger and reads the
+    // table's column profile and partitioning, without any DDL or index
+    // work. False when the table or the ledger does not exist yet.
+    bool inspectSchema();
+    // The sets this run may harvest: those whose (repository, set) advisory
+    // lock it holds. Locks stay held until the caller's Release goes.
+    std::vector<std::string> lockSets(const std::vector<std::string>& set_specs);
+    bool interrupted() const { return interrupt_ && interrupt_(); }
+    // Last 2 days, local time
+    std::pair<std::string, std::string> recentRange();
+    void loadLaneGaps(const std::string& lane, const std::vector<std::string>& set_specs,
+                      const std::string& start, const std::string& end,
+                      std::vector<std::string>& missing_dates,
+                      std::map<std::string, long>& day_counts);
+    
+    // Scheduled harvesting; counts are added to `total_records` as windows
+    // finish, so they survive a stop
+    int harvestScheduled(const std::vector<std::string>& set_specs, bool include_recent,
+                         const std::string& start_date, const std::string& end_date);
+    // max_inflight > 1: windows pulled from one queue by that many tasks on
+    // an event loop, each fetching its window's pages in turn
+    int harvestConcurrent(const std::vector<std::string>& set_specs, bool include_recent,
+                          const std::string& start, const std::string& end);
+    Task<void> windowWorker(EventLoop& loop, std::deque<std::shared_ptr<WindowJob>>& queue,
+                            int& total_records);
+    void scheduleWindow(RequestScheduler& scheduler, RequestPriority priority,
+                        std::shared_ptr<WindowJob> job, int& total_records,
+                        std::function<void(WindowJob&)> on_done = nullptr);
+    void scheduleBackfillLane(RequestScheduler& scheduler, std::shared_ptr<BackfillLane> state,
+                              const std::vector<std::string>& set_specs, int& total_records);
+    
+    // One set's ListIdentifiers probes, month by month, on the event loop
+    Task<void> probeSet(EventLoop& loop, std::string set_spec,
+                        std::vector<DateRange> windows, VerifyState& state);
+    
+    // Window execution. A non-empty `watermark` is committed for the
+    // window's sets together with its last page.
+    std::optional<Checkpoint> loadCheckpoint(const std::string& lane);
+    std::shared_ptr<WindowJob> makeWindowJob(const std::string& set_spec,
+                                             const std::vector<std::string>& set_specs,
+                                             const std::string& from_date,
+                                             const std::string& until_date,
+                                             const Checkpoint* resume = nullptr,
+                                             const std::string& watermark = "");
+    // One request; returns true while the window has pages left
+    bool stepWindow(WindowJob& job);
+    // Commits a fetched page and finishes or checkpoints the window
+    bool applyPage(WindowJob& job, OaiPage& page);
+    // All remaining pages; throws HarvestInterrupted between pages
+    int runWindow(WindowJob& job);
+    void commitPage(WindowJob& job, std::vector<Record>& records, bool last_page);
+    void advanceWatermark(WindowJob& job);
+    // Marks the window's days 'running' in the ledger before its first page
+    void startWindow(WindowJob& job);
+    // Logs the window complete through job.final_until, if set; days after
+    // it are still changing upstream and stay 'running'
+    void logComplete(const WindowJob& job, const HarvestWindow& window);
+    void finishWindow(WindowJob& job);
+    void failWindow(WindowJob& job, const std::string& error);
     int harvestSetSpec(const std::string& set_spec, const std::string& from_date, 
-                       const std::string& until_date);
-    void insertRecords(const std::vector<Record>& records, const std::string& set_spec);
+                       const std::string& until_date, const std::string& watermark = "");
+    int harvestSets(const std::vector<std::string>& set_specs, const std::string& from_date,
+                    const std::string& until_date, const std::string& watermark = "");
+    
+    // The sink for one RECORD_SINKS entry: postgres, ndjson:<file>,
+    // archive:<dir>, sqlite:<file> or columnar:<dir>
+    std::unique_ptr<RecordSink> makeSink(const std::string& spec);
+    std::string getLatestDate(const std::string& set_spec);
+    long countLocal(const std::string& set_spec, const std::string& from_date,
+                    const std::string& until_date);
     std::vector<std::string> getMissingDates(const std::string& start_date, 
                                               const std::string& end_date,
                                               const std::string& set_spec);
+    std::map<std::string, long> getDayCounts(const std::string& start_date,
+                                             const std::string& end_date,
+                                             const std::string& set_spec);
 };
@@ -0,0 +1,56 @@
+/**
+ * @file Mirror.h
+ * @brief Network-only harvest into the raw page archive
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../oai/EventLoop.h"
+#include "../oai/OaiClient.h"
+#include "Archive.h"
+#include "BackfillPlanner.h"
+#include "Repository.h"
+
+// Downloads (set, month) windows into a PageArchive at the repository's
+// rate and never opens a database connection; Harvester::loadArchive()
+// ingests the result separately
+class Mirror {
+public:
+    Mirror(const Repository& repository, const std::string& archive_dir);
+    
+    // Set-less: one stream per month without a set parameter
+    void setSetless(bool enabled) { setless_ = enabled; }
+    void setInterrupt(std::function<bool()> interrupt) { interrupt_ = std::move(interrupt); }
+    
+    // Months in the range that the archive lacks or holds only in part
+    // (the running month) are fetched; returns the records archived
+    long run(const std::string& start_date, const std::string& end_date,
+             const std::vector<std::string>& set_specs);
+    
+private:
+    struct PendingWindow {
+        std::string set_spec;
+        DateRange range;
+    };
+    
+    struct Progress {
+        int windows = 0;
+        int failed = 0;
+        long pages = 0;
+        long records = 0;
+    };
+    
+    bool interrupted() const { return interrupt_ && interrupt_(); }
+    Task<void> worker(EventLoop& loop, std::deque<PendingWindow>& queue, Progress& progress);
+    
+    Repository repository_;
+    OaiClient client_;
+    PageArchive archive_;
+    bool setless_;
+    std::function<bool()> interrupt_;
+};
@@ -0,0 +1,38 @@
+/**
+ * @file MultiHarvester.h
+ * @brief Concurrent harvesting of several OAI-PMH repositories
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Harvester.h"
+#include "Repository.h"
+
+class MultiHarvester {
+public:
+    // Receives a harvester bound to the repository and returns its records
+    using Job = std::function<int(Harvester&, const Repository&)>;
+    
+    // Receives only the repository, for jobs that need no database
+    using RepositoryJob = std::function<int(const Repository&)>;
+    
+    explicit MultiHarvester(std::vector<Repository> repositories);
+    
+    // Runs `job` for every repository at once, each on its own thread with
+    // its own database connection. Requests stay paced per host by the
+    // shared rate limiters, so a slow repository never holds up the others.
+    // A failing repository is logged and counted; the rest carry on.
+    int run(const Job& job);
+    
+    // As run(), without opening a connection per repository
+    int runEach(const RepositoryJob& job);
+    
+    size_t failures() const { return failures_; }
+    
+private:
+    std::vector<Repository> repositories_;
+    size_t failures_;
+};
@@ -7,17 +7,31 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
 class RateLimiter {
 public:
     RateLimiter(int delay_seconds);
     
+    // Thread-safe: concurrent callers are handed consecutive slots
     void wait_before_request();
+    // Books the next slot without sleeping, for callers that wait on an
+    // event loop instead of blocking the thread
+    std::chrono::steady_clock::time_point reserve();
+    // No slot before `until`, for every user of the limiter (Retry-After)
+    void defer(std::chrono::steady_clock::time_point until);
     void wait_between_batches();
     void wait_between_set_specs();
     
+    // One limiter per host for the whole process, so every client talking
+    // to a host shares its budget; the strictest delay requested wins
+    static std::shared_ptr<RateLimiter> forHost(const std::string& host, int delay_seconds);
+    
 private:
     int delay_ms_;
     std::chrono::steady_clock::time_point last_request_;
+    std::mutex mutex_;
 };
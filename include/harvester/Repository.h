@@ -0,0 +1,39 @@
+/**
+ * @file Repository.h
+ * @brief OAI-PMH repository registry entries
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One OAI-PMH source and where its records go
+struct Repository {
+    std::string name;
+    std::string base_url;
+    std::string metadata_prefix = "oai_dc";
+    std::vector<std::string> set_specs;
+    int rate_limit_delay = 3;           // seconds between requests to the host
+    int max_retries = 3;
+    // Windows fetched at once by backfill; above 1 only for mirrors and
+    // stand-in servers without a one-request-at-a-time policy
+    int max_inflight = 1;
+    std::string table;                  // target table in POSTGRES_SCHEMA
+    // Prepended to harvest_log, harvest_watermark and harvest_checkpoint so
+    // repositories sharing a schema keep separate ledgers
+    std::string ledger_prefix;
+    
+    // Host part of base_url; requests to one host share a rate limiter
+    std::string host() const;
+    
+    // The single repository described by the environment (ARXIV_BASE_URL,
+    // POSTGRES_TABLE, ...), with the existing unprefixed ledger tables
+    static Repository fromConfig(const std::vector<std::string>& set_specs);
+    
+    // JSON registry: an array of objects with name, base_url, set_specs and
+    // optional metadata_prefix, rate_limit_delay, max_retries, max_inflight, table and
+    // ledger_prefix (defaults: table = name, ledger_prefix = name + "_")
+    static std::vector<Repository> loadRegistry(const std::string& path);
+};
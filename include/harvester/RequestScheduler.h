@@ -0,0 +1,53 @@
+/**
+ * @file RequestScheduler.h
+ * @brief Priority queue of upstream requests with one request in flight
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Lower values run first
+enum class RequestPriority { Recent = 0, Resumption = 1, Backfill = 2 };
+
+class RequestScheduler {
+public:
+    // A step issues at most one upstream request. It returns the priority to
+    // requeue itself at, or nullopt once it has no more work.
+    using Step = std::function<std::optional<RequestPriority>()>;
+    
+    void submit(RequestPriority priority, const std::string& label, Step step);
+    
+    // Runs steps by priority, FIFO within a priority, until the queue drains
+    // or `stop` returns true; returns the number of steps run
+    size_t run(const std::function<bool()>& stop = nullptr);
+    
+    bool empty() const { return queue_.empty(); }
+    size_t pending() const { return queue_.size(); }
+    
+private:
+    struct Entry {
+        RequestPriority priority;
+        uint64_t sequence;
+        std::string label;
+        Step step;
+    };
+    
+    struct RunsLater {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.priority != b.priority) {
+                return a.priority > b.priority;
+            }
+            return a.sequence > b.sequence;
+        }
+    };
+    
+    std::priority_queue<Entry, std::vector<Entry>, RunsLater> queue_;
+    uint64_t next_sequence_ = 0;
+};
@@ -0,0 +1,104 @@
+/**
+ * @file EventLoop.h
+ * @brief Single-threaded curl multi event loop with coroutine awaitables
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <curl/curl.h>
+#include "../utils/Task.h"
+
+struct DetachedTask;
+
+// Outcome of one transfer; transport failures have status 0 and an error
+struct HttpResponse {
+    long status = 0;
+    std::string body;
+    std::string error;
+    int retry_after = -1;           // Retry-After in seconds, if sent
+    
+    bool ok() const { return error.empty() && status > 0 && status < 400; }
+};
+
+// Drives many transfers on one thread through curl_multi_socket_action and
+// poll(). Tasks suspend on fetch() and sleep awaitables instead of blocking,
+// so any number of logical harvest tasks share the thread.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    
+    class FetchAwaiter {
+    public:
+        FetchAwaiter(EventLoop& loop, std::string url, long timeout_seconds);
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> waiter);
+        HttpResponse await_resume() { return std::move(response_); }
+        
+    private:
+        friend class EventLoop;
+        EventLoop& loop_;
+        std::string url_;
+        long timeout_seconds_;
+        HttpResponse response_;
+        std::coroutine_handle<> waiter_;
+    };
+    
+    class SleepAwaiter {
+    public:
+        SleepAwaiter(EventLoop& loop, Clock::time_point until) : loop_(loop), until_(until) {}
+        bool await_ready() const noexcept { return Clock::now() >= until_; }
+        void await_suspend(std::coroutine_handle<> waiter);
+        void await_resume() noexcept {}
+        
+    private:
+        EventLoop& loop_;
+        Clock::time_point until_;
+    };
+    
+    // co_await loop.fetch(url): one GET, redirects followed
+    FetchAwaiter fetch(std::string url, long timeout_seconds = 60);
+    SleepAwaiter sleepUntil(Clock::time_point until) { return SleepAwaiter(*this, until); }
+    SleepAwaiter sleepFor(Clock::duration duration) { return sleepUntil(Clock::now() + duration); }
+    
+    // Starts a task that runs until it completes; exceptions are logged
+    void spawn(Task<void> task);
+    // Runs until every spawned task has finished
+    void run();
+    
+    size_t inFlight() const { return transfers_.size(); }
+    
+    // curl write and header callbacks filling the HttpResponse passed as
+    // userp; blocking easy handles use them too
+    static size_t writeCallback(char* data, size_t size, size_t nmemb, void* userp);
+    static size_t headerCallback(char* data, size_t size, size_t nmemb, void* userp);
+    
+private:
+    static int socketCallback(CURL* easy, curl_socket_t socket, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeout_ms, void* userp);
+    
+    static DetachedTask runDetached(EventLoop& loop, Task<void> task);
+    void start(FetchAwaiter& awaiter);
+    void collectFinished();
+    void pollOnce();
+    
+    CURLM* multi_;
+    std::map<curl_socket_t, int> sockets_;      // socket -> CURL_POLL_* interest
+    bool curl_timer_set_;
+    Clock::time_point curl_deadline_;
+    std::multimap<Clock::time_point, std::coroutine_handle<>> timers_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::set<CURL*> transfers_;
+    size_t tasks_;
+};
@@ -6,38 +6,92 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <curl/curl.h>
+#include "../utils/Task.h"
+#include "EventLoop.h"
 #include "Record.h"
 
+class RateLimiter;
+
+// One page of a ListRecords response and its resumptionToken state
+struct OaiPage {
+    std::vector<Record> records;
+    std::string resumption_token;   // empty on the last page
+    std::string token_expiration;   // expirationDate attribute, if any
+    long complete_list_size = -1;   // -1 when the server does not report it
+    long cursor = -1;
+};
+
 class OaiClient {
 public:
     OaiClient(const std::string& base_url);
     ~OaiClient();
     
-    // Harvest records from OAI-PMH
+    // Harvest records from OAI-PMH, following resumption tokens to the end
     std::vector<Record> listRecords(
         const std::string& metadata_prefix,
         const std::string& set_spec,
         const std::string& from_date,
         const std::string& until_date);
     
+    // Page-at-a-time access; both throw if the page cannot be fetched
+    OaiPage listRecordsPage(
+        const std::string& metadata_prefix,
+        const std::string& set_spec,
+        const std::string& from_date,
+        const std::string& until_date);
+    OaiPage resumeListRecords(const std::string& resumption_token);
+    
+    // First ListIdentifiers page: headers only (records carry no metadata).
+    // Enough to read completeListSize without downloading the records.
+    OaiPage listIdentifiersPage(
+        const std::string& metadata_prefix,
+        const std::string& set_spec,
+        const std::string& from_date,
+        const std::string& until_date);
+    
+    // Coroutine variants on a shared EventLoop: the calling task suspends
+    // for the rate-limit slot and the transfer instead of blocking a thread.
+    // Retries and rate limiting match the blocking calls.
+    Task<std::string> fetch(EventLoop& loop, std::string url);
+    Task<OaiPage> listRecordsPageAsync(EventLoop& loop, std::string metadata_prefix,
+                                       std::string set_spec, std::string from_date,
+                                       std::string until_date);
+    Task<OaiPage> resumeListRecordsAsync(EventLoop& loop, std::string resumption_token);
+    Task<OaiPage> listIdentifiersPageAsync(EventLoop& loop, std::string metadata_prefix,
+                                           std::string set_spec, std::string from_date,
+                                           std::string until_date);
+    
+    // Request URLs and response parsing, for callers that keep the raw
+    // response (the page archive) and parse it themselves
+    std::string listUrl(const std::string& verb, const std::string& metadata_prefix,
+                        const std::string& set_spec, const std::string& from_date,
+                        const std::string& until_date) const;
+    std::string resumeUrl(const std::string& resumption_token) const;
+    static OaiPage parseXmlResponse(std::string_view xml);
+    
     // HTTP client methods
     void setRateLimitDelay(int delay_seconds);
     void setMaxRetries(int max_retries);
     
+    // Share a limiter with other clients of the same host (see
+    // RateLimiter::forHost); replaces the client's private one
+    void setRateLimiter(std::shared_ptr<RateLimiter> limiter);
+    
 private:
     std::string base_url_;
     CURL* curl_;
-    int rate_limit_delay_;
     int max_retries_;
+    std::shared_ptr<RateLimiter> rate_limiter_;
     
     // Internal methods
     std::string fetchUrl(const std::string& url);
     void rateLimitWait();
-    std::vector<Record> parseXmlResponse(const std::string& xml);
-    
-    // CURL callback
-    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    std::string fetchWithRetries(const std::string& url);
+    // Holds back every user of the host's limiter for a server Retry-After
+    void honourRetryAfter(const HttpResponse& response);
 };
@@ -23,4 +23,16 @@ struct Record {
     std::vector<std::string> metadata_subject;
     std::vector<std::string> metadata_title;
     std::string metadata_type;
+    
+    // True if the record is in set_spec or one of its subsets
+    // ("cs" matches "cs" and "cs:cs:AI")
+    bool inSet(const std::string& set_spec) const {
+        for (const auto& spec : header_setSpecs) {
+            if (spec.compare(0, set_spec.size(), set_spec) == 0 &&
+                (spec.size() == set_spec.size() || spec[set_spec.size()] == ':')) {
+                return true;
+            }
+        }
+        return false;
+    }
 };
@@ -0,0 +1,31 @@
+/**
+ * @file ArchiveSink.h
+ * @brief Record sink keeping a month-partitioned NDJSON archive
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include "RecordSink.h"
+#include "WatermarkFile.h"
+
+// <dir>/<YYYY>/<YYYY-MM>.ndjson by header_datestamp, so a month can be
+// shipped, compressed or re-read on its own; watermarks in
+// <dir>/watermark.json
+class ArchiveSink : public RecordSink {
+public:
+    explicit ArchiveSink(std::string dir);
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    void flush() override;
+    void commitWatermark(const std::vector<std::string>& set_specs,
+                         const std::string& day) override;
+    
+private:
+    std::string dir_;
+    std::map<std::string, std::string> pending_;  // YYYY-MM -> NDJSON lines
+    WatermarkFile watermarks_;
+};
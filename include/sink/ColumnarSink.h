@@ -0,0 +1,35 @@
+/**
+ * @file ColumnarSink.h
+ * @brief Record sink exporting column-major row groups
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "RecordSink.h"
+#include "WatermarkFile.h"
+
+// Every flush writes one row group, <dir>/part-NNNNNN/, holding one file per
+// column with one JSON value per line (line i of every file is row i). The
+// group is written under a temporary name and renamed, so readers never see
+// a partial one. Analytics tools can read single columns without touching
+// the abstracts.
+class ColumnarSink : public RecordSink {
+public:
+    explicit ColumnarSink(std::string dir);
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    void flush() override;
+    void commitWatermark(const std::vector<std::string>& set_specs,
+                         const std::string& day) override;
+    
+private:
+    std::string dir_;
+    int next_part_;
+    size_t rows_;
+    std::vector<std::string> columns_;  // buffered values, in column order
+    WatermarkFile watermarks_;
+};
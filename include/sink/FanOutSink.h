@@ -0,0 +1,36 @@
+/**
+ * @file FanOutSink.h
+ * @brief Record sink forwarding to several sinks in parallel
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "RecordSink.h"
+
+// Hands each call to every sink at once, one thread per sink, and returns
+// when all of them are done. One harvest feeds all downstream consumers,
+// at the pace of the slowest. If any sink fails, the first error is
+// rethrown once the others have finished the same call, so the page is
+// retried everywhere. Upserting sinks absorb the repeat; appending sinks
+// store it again, and their readers keep the last row per
+// header_identifier.
+class FanOutSink : public RecordSink {
+public:
+    explicit FanOutSink(std::vector<std::unique_ptr<RecordSink>> sinks);
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    void flush() override;
+    void commitWatermark(const std::vector<std::string>& set_specs,
+                         const std::string& day) override;
+    
+private:
+    void forEach(const std::function<void(RecordSink&)>& call);
+    
+    std::vector<std::unique_ptr<RecordSink>> sinks_;
+};
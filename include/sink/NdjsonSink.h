@@ -0,0 +1,38 @@
+/**
+ * @file NdjsonSink.h
+ * @brief Record sink appending newline-delimited JSON
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include "RecordSink.h"
+#include "WatermarkFile.h"
+
+// One JSON object per record, appended to `path`; watermarks go to
+// <path>.watermark.json. A re-harvested record is appended again, so
+// consumers keep the last line per header_identifier.
+class NdjsonSink : public RecordSink {
+public:
+    explicit NdjsonSink(std::string path);
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    void flush() override;
+    void commitWatermark(const std::vector<std::string>& set_specs,
+                         const std::string& day) override;
+    
+    // The record as one JSON object with the table's column names
+    static void appendJson(std::string& out, const Record& record);
+    
+    // Appends `lines` to the file all or nothing and fsyncs it: after a
+    // failed write the file is cut back to its old length before the error
+    // is thrown
+    static void appendFile(const std::string& path, const std::string& lines);
+    
+private:
+    std::string path_;
+    std::string buffer_;
+    WatermarkFile watermarks_;
+};
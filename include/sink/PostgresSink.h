@@ -0,0 +1,35 @@
+/**
+ * @file PostgresSink.h
+ * @brief Record sink writing to the metadata table
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include "../db/CopyEncoder.h"
+#include "../db/Database.h"
+#include "RecordSink.h"
+
+// Each batch is streamed into a session-local staging table with binary
+// COPY and merged with one set-based upsert, in its own transaction
+class PostgresSink : public RecordSink {
+public:
+    PostgresSink(Database& db, std::string schema_name, std::string table_name,
+                 PartitionScheme scheme, ColumnProfile profile);
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    // Batches commit as they are written
+    void flush() override {}
+    // The harvester keeps its watermarks in this database already
+    void commitWatermark(const std::vector<std::string>&, const std::string&) override {}
+    
+private:
+    Database& db_;
+    std::string schema_;
+    std::string table_;
+    PartitionScheme scheme_;
+    ColumnProfile profile_;
+    CopyEncoder encoder_;
+};
@@ -0,0 +1,37 @@
+/**
+ * @file RecordSink.h
+ * @brief Destination of harvested records
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../oai/Record.h"
+
+// Where harvested pages go. The harvester writes each page, flushes before
+// it checkpoints or logs the window, and commits the set watermark once a
+// window's last page is flushed. So a sink never holds a watermark ahead of
+// its data, and a crash replays at most the pages since the last flush.
+class RecordSink {
+public:
+    virtual ~RecordSink() = default;
+    
+    // Short description for logs ("postgres arxiv.metadata", "ndjson out.json")
+    virtual std::string name() const = 0;
+    
+    // Writes one page of records; may buffer. The postgres and sqlite sinks
+    // upsert by header_identifier, the ndjson, archive and columnar sinks
+    // append, so a replayed page is stored there twice.
+    virtual void writeBatch(const std::vector<Record>& records) = 0;
+    
+    // Everything written so far is durable once this returns
+    virtual void flush() = 0;
+    
+    // The records of `set_specs` are complete through `day` (YYYY-MM-DD);
+    // marks never move back
+    virtual void commitWatermark(const std::vector<std::string>& set_specs,
+                                 const std::string& day) = 0;
+};
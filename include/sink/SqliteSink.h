@@ -0,0 +1,37 @@
+/**
+ * @file SqliteSink.h
+ * @brief Record sink writing to a SQLite database
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+#include <sqlite3.h>
+#include "RecordSink.h"
+
+// A single-file copy of the metadata table: `records` with the table's
+// columns (multi-valued fields as JSON text) and `watermarks`. Each batch
+// is one upsert transaction in WAL mode.
+class SqliteSink : public RecordSink {
+public:
+    explicit SqliteSink(std::string path);
+    ~SqliteSink() override;
+    SqliteSink(const SqliteSink&) = delete;
+    SqliteSink& operator=(const SqliteSink&) = delete;
+    
+    std::string name() const override;
+    void writeBatch(const std::vector<Record>& records) override;
+    // Batches commit as they are written
+    void flush() override {}
+    void commitWatermark(const std::vector<std::string>& set_specs,
+                         const std::string& day) override;
+    
+private:
+    void exec(const char* sql);
+    
+    std::string path_;
+    sqlite3* db_;
+    sqlite3_stmt* upsert_;
+    sqlite3_stmt* watermark_;
+};
@@ -0,0 +1,23 @@
+/**
+ * @file WatermarkFile.h
+ * @brief Set high-water marks kept in a JSON file next to a file sink
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// {"cs": "2026-10-15", ...}, replaced atomically on every advance
+class WatermarkFile {
+public:
+    explicit WatermarkFile(std::string path);
+    
+    void advance(const std::vector<std::string>& set_specs, const std::string& day);
+    
+private:
+    std::string path_;
+    std::map<std::string, std::string> marks_;
+};
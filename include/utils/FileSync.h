@@ -0,0 +1,21 @@
+/**
+ * @file FileSync.h
+ * @brief Durable file writes for the file-based record sinks
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <string>
+
+// Writes that survive a power loss once they return. A rename or a new file
+// is only durable after its directory is synced too.
+class FileSync {
+public:
+    // Writes `data` to `path`, appending or replacing it, then fflush and
+    // fsync; throws std::runtime_error on any failure
+    static void write(const std::string& path, const std::string& data, bool append);
+    
+    // fsync on the directory itself, so its entries are on disk
+    static void syncDirectory(const std::string& path);
+};
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <nlohmann/json.hpp>
 
@@ -15,10 +16,21 @@ public:
     // Convert vector to JSON array string
     static std::string vectorToJson(const std::vector<std::string>& vec);
     
+    // Streaming writers: append directly to a caller-owned buffer without
+    // building json nodes. Input is expected to be valid UTF-8 (libxml2
+    // always hands out UTF-8) and is copied through unvalidated.
+    static void appendStringArray(std::string& out, const std::vector<std::string>& vec);
+    static void appendQuoted(std::string& out, std::string_view str);
+    
     // Parse JSON string to vector
     static std::vector<std::string> jsonToVector(const std::string& json_str);
     
-    // Safe JSON serialization
+    // Safe JSON serialization: valid JSON text is normalized, anything else
+    // becomes a JSON string. Never throws, so it is fine in per-record loops.
     static std::string safeSerialize(const std::string& str);
     static std::string safeSerialize(const std::vector<std::string>& vec);
+    
+    // Cheap first/last character check; false means the text is certainly
+    // not a JSON document, true means it is worth a (non-throwing) parse
+    static bool mayBeJson(std::string_view str);
 };
@@ -0,0 +1,28 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory map of a file
+ * @author Bernard Chase
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Maps a whole file read-only. Parsers read straight out of the page cache,
+// with no read() copy and no buffer to size up front.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    std::string_view view() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+    
+private:
+    const char* data_;
+    size_t size_;
+};
@@ -5,6 +5,7 @@
  */
 
 #include "config/Config.h"
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -57,12 +58,47 @@ void Config::load() {
   port_ = std::stoi(getEnv("POSTGRES_PORT", "5432"));
   schema_ = getEnv("POSTGRES_SCHEMA", "arxiv");
   table_ = getEnv("POSTGRES_TABLE", "metadata");
+  index_workers_ = std::stoi(getEnv("POSTGRES_INDEX_WORKERS", "4"));
+  partitioning_ = getEnv("POSTGRES_PARTITIONING", "none");
+  column_profile_ = getEnv("POSTGRES_COLUMN_PROFILE", "jsonb");
+  lock_wait_seconds_ = std::stoi(getEnv("LOCK_WAIT_SECONDS", "0"));
 
   // arXiv settings
+  base_url_ = getEnv("ARXIV_BASE_URL", "https://oaipmh.arxiv.org/oai");
+  repositories_file_ = getEnv("REPOSITORIES_FILE", "");
   rate_limit_delay_ = std::stoi(getEnv("ARXIV_RATE_LIMIT_DELAY", "3"));
   batch_size_ = std::stoi(getEnv("ARXIV_BATCH_SIZE", "2000"));
   max_retries_ = std::stoi(getEnv("ARXIV_MAX_RETRIES", "3"));
+  max_inflight_ = std::max(1, std::stoi(getEnv("ARXIV_MAX_INFLIGHT", "1")));
   retry_after_ = std::stoi(getEnv("ARXIV_RETRY_AFTER", "5"));
+  backfill_target_pages_ = std::stoi(getEnv("BACKFILL_TARGET_PAGES", "20"));
+  checkpoint_file_ = getEnv("CHECKPOINT_FILE", "");
+  archive_dir_ = getEnv("ARCHIVE_DIR", "archive");
+  load_parsers_ = std::stoi(getEnv("LOAD_PARSERS", "0"));
+  load_connections_ = std::stoi(getEnv("LOAD_COPY_CONNECTIONS", "4"));
+
+  // Sink settings
+  record_sinks_.clear();
+  std::stringstream sinks(getEnv("RECORD_SINKS", "postgres"));
+  for (std::string sink; std::getline(sinks, sink, ',');) {
+    sink.erase(0, sink.find_first_not_of(" \t"));
+    sink.erase(sink.find_last_not_of(" \t") + 1);
+    if (!sink.empty()) {
+      record_sinks_.push_back(sink);
+    }
+  }
+  if (record_sinks_.empty()) {
+    record_sinks_.push_back("postgres");
+  }
+
+  // Job queue settings
+  worker_id_ = getEnv("HARVEST_WORKER_ID", "");
+  job_lease_seconds_ = std::stoi(getEnv("JOB_LEASE_SECONDS", "600"));
+  job_max_attempts_ = std::stoi(getEnv("JOB_MAX_ATTEMPTS", "5"));
+
+  // Daemon settings
+  daemon_recent_time_ = getEnv("DAEMON_RECENT_TIME", "02:00");
+  daemon_retry_delay_ = std::stoi(getEnv("DAEMON_RETRY_DELAY", "300"));
 
   // Docker settings
   docker_host_ = getEnv("DOCKER_POSTGRES_HOST", "db-local");
@@ -0,0 +1,67 @@
+/**
+ * @file AdvisoryLock.cpp
+ * @brief Session advisory locks that keep overlapping runs off the same sets implementation
+ * @author Bernard Chase
+ */
+
+#include "db/AdvisoryLock.h"
+#include "utils/Logger.h"
+#include <chrono>
+#include <thread>
+
+// Two-key form: the first key keeps these locks apart from any other
+// advisory locks taken in the same database
+static const char *kLockNamespace = "arhida";
+
+AdvisoryLocks::AdvisoryLocks(Database &db) : db_(db) {}
+
+bool AdvisoryLocks::tryLock(const std::string &key, int wait_seconds) {
+  if (held_.count(key)) {
+    return true;
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  auto deadline = started + std::chrono::seconds(wait_seconds);
+  bool locked = false;
+
+  while (true) {
+    PGresult *res = db_.query(
+        "SELECT pg_try_advisory_lock(hashtext($1), hashtext($2))",
+        {kLockNamespace, key.c_str()});
+    locked = std::string(PQgetvalue(res, 0, 0)) == "t";
+    PQclear(res);
+    if (locked || std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+
+  stats_.waited_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - started)
+                          .count();
+  if (locked) {
+    held_.insert(key);
+    stats_.acquired++;
+  } else {
+    stats_.skipped++;
+  }
+  return locked;
+}
+
+void AdvisoryLocks::unlockAll() {
+  std::set<std::string> held;
+  held.swap(held_);
+  for (const auto &key : held) {
+    PQclear(db_.query("SELECT pg_advisory_unlock(hashtext($1), hashtext($2))",
+                      {kLockNamespace, key.c_str()}));
+  }
+}
+
+AdvisoryLocks::Release::~Release() {
+  try {
+    locks_.unlockAll();
+  } catch (const std::exception &e) {
+    // A broken connection has already dropped its session locks
+    spdlog::warn("Could not release advisory locks: {}", e.what());
+  }
+}
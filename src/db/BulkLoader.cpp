@@ -0,0 +1,170 @@
+/**
+ * @file BulkLoader.cpp
+ * @brief Parallel COPY into staging tables with a single set-based merge
+ * implementation
+ * @author Bernard Chase
+ */
+
+#include "db/BulkLoader.h"
+#include "db/RecordTable.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <unistd.h>
+
+BulkLoader::BulkLoader(std::string schema_name, std::string table_name,
+                       PartitionScheme scheme, int connections)
+    : schema_(std::move(schema_name)), table_(std::move(table_name)),
+      scheme_(scheme), queue_(2 * static_cast<size_t>(std::max(1, connections))),
+      copied_rows_(0), copied_bytes_(0), copy_seconds_(0), merge_seconds_(0) {
+  connections_.resize(static_cast<size_t>(std::max(1, connections)));
+}
+
+BulkLoader::~BulkLoader() {
+  try {
+    stop();
+    if (!connections_.empty() && connections_[0] &&
+        connections_[0]->isConnected()) {
+      for (size_t i = 0; i < connections_.size(); ++i) {
+        connections_[0]->execute("DROP TABLE IF EXISTS " + stagingTable(i));
+      }
+    }
+  } catch (const std::exception &e) {
+    spdlog::warn("Could not drop bulk-load staging tables: {}", e.what());
+  }
+}
+
+std::string BulkLoader::stagingTable(size_t index) const {
+  // The pid keeps concurrent loaders into one table apart
+  return schema_ + "." + table_ + "_load_" + std::to_string(::getpid()) +
+         "_" + std::to_string(index);
+}
+
+void BulkLoader::start() {
+  const std::string target = schema_ + "." + table_;
+
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    connections_[i] = std::make_unique<Database>();
+    connections_[i]->connect();
+    // Unlogged: staged rows are rebuilt from the source after a crash anyway
+    connections_[i]->execute("DROP TABLE IF EXISTS " + stagingTable(i));
+    connections_[i]->execute("CREATE UNLOGGED TABLE " + stagingTable(i) +
+                             " AS SELECT" + RecordTable::columns() + " FROM " +
+                             target + " WITH NO DATA");
+  }
+
+  spdlog::info("Bulk loading {} over {} COPY connections", target,
+               connections_.size());
+
+  started_ = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    threads_.emplace_back([this, i] { copyWorker(i); });
+  }
+}
+
+void BulkLoader::copyWorker(size_t index) {
+  Database &db = *connections_[index];
+  const std::string copy_query = "COPY " + stagingTable(index) + " (" +
+                                 RecordTable::columns() +
+                                 ") FROM STDIN WITH (FORMAT binary)";
+
+  // After a failure the queue is still drained, so producers never block
+  // on a dead consumer; finish() reports the error
+  bool failed = false;
+  while (auto stream = queue_.pop()) {
+    if (failed) {
+      continue;
+    }
+    try {
+      db.copyFrom(copy_query, stream->data);
+      copied_rows_ += stream->rows;
+      copied_bytes_ += static_cast<long>(stream->data.size());
+    } catch (const std::exception &e) {
+      failed = true;
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (error_.empty()) {
+        error_ = e.what();
+      }
+    }
+  }
+}
+
+void BulkLoader::submit(std::string data, long rows) {
+  queue_.push(Stream{std::move(data), rows});
+}
+
+void BulkLoader::stop() {
+  queue_.close();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+void BulkLoader::finish(Database &db,
+                        const std::function<void()> &in_transaction) {
+  stop();
+  copy_seconds_ = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - started_)
+                      .count();
+  if (!error_.empty()) {
+    throw std::runtime_error("Bulk COPY failed: " + error_);
+  }
+
+  auto merge_started = std::chrono::steady_clock::now();
+
+  std::string staged;
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    staged += (i ? " UNION ALL SELECT * FROM " : "(SELECT * FROM ") +
+              stagingTable(i);
+  }
+  staged += ") AS staged";
+
+  if (scheme_ != PartitionScheme::None) {
+    PGresult *res = db.query("SELECT DISTINCT to_char(header_datestamp, "
+                             "'YYYY-MM') FROM " +
+                             staged);
+    std::vector<std::string> months;
+    for (int i = 0; i < PQntuples(res); ++i) {
+      months.push_back(PQgetvalue(res, i, 0));
+    }
+    PQclear(res);
+    db.ensurePartitions(schema_, table_, scheme_, months);
+  }
+
+  db.execute("BEGIN");
+  try {
+    // The sort behind DISTINCT ON covers the whole load
+    db.execute("SET LOCAL work_mem = '1GB'");
+    db.execute(RecordTable::mergeQuery(schema_ + "." + table_, staged, scheme_));
+    if (in_transaction) {
+      in_transaction();
+    }
+    db.execute("COMMIT");
+  } catch (const std::exception &e) {
+    spdlog::error("Error merging staged rows into {}.{}: {}", schema_, table_,
+                  e.what());
+    db.execute("ROLLBACK");
+    throw;
+  }
+
+  merge_seconds_ = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - merge_started)
+                       .count();
+}
+
+void BulkLoader::logStages(const std::vector<LoadStage> &stages) {
+  spdlog::info("Load stages:");
+  for (const auto &stage : stages) {
+    double rate = stage.seconds > 0 ? stage.records / stage.seconds : 0;
+    if (stage.bytes > 0) {
+      spdlog::info("  {:<6} {:>10} records in {:>8.1f} s  {:>10.0f} "
+                   "records/s  {:>7.1f} MB/s",
+                   stage.name, stage.records, stage.seconds, rate,
+                   stage.bytes / 1e6 / std::max(stage.seconds, 1e-9));
+    } else {
+      spdlog::info("  {:<6} {:>10} records in {:>8.1f} s  {:>10.0f} "
+                   "records/s",
+                   stage.name, stage.records, stage.seconds, rate);
+    }
+  }
+}
@@ -0,0 +1,158 @@
+/**
+ * @file CopyEncoder.cpp
+ * @brief Encoder for PostgreSQL binary COPY streams implementation
+ * @author Bernard Chase
+ */
+
+#include "db/CopyEncoder.h"
+#include "utils/JsonHelper.h"
+#include <charconv>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+// Binary COPY signature, flags field and header extension length
+constexpr char kCopyHeader[] = "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0";
+constexpr size_t kCopyHeaderSize = 19;
+
+constexpr int32_t kTextOid = 25;
+constexpr uint8_t kJsonbVersion = 1;
+
+// Parse a fixed-width numeric field; returns false on malformed input
+bool parseField(std::string_view text, size_t pos, size_t len, int &out) {
+  if (text.size() < pos + len) {
+    return false;
+  }
+  auto result =
+      std::from_chars(text.data() + pos, text.data() + pos + len, out);
+  return result.ec == std::errc() && result.ptr == text.data() + pos + len;
+}
+
+} // namespace
+
+CopyEncoder::CopyEncoder() : rows_(0) { clear(); }
+
+void CopyEncoder::clear() {
+  buffer_.assign(kCopyHeader, kCopyHeaderSize);
+  rows_ = 0;
+}
+
+std::string CopyEncoder::take() {
+  std::string data = std::move(buffer_);
+  clear();
+  return data;
+}
+
+void CopyEncoder::putInt16(int16_t value) {
+  uint16_t v = static_cast<uint16_t>(value);
+  char bytes[2] = {static_cast<char>(v >> 8), static_cast<char>(v)};
+  buffer_.append(bytes, sizeof(bytes));
+}
+
+void CopyEncoder::putInt32(int32_t value) {
+  uint32_t v = static_cast<uint32_t>(value);
+  char bytes[4] = {static_cast<char>(v >> 24), static_cast<char>(v >> 16),
+                   static_cast<char>(v >> 8), static_cast<char>(v)};
+  buffer_.append(bytes, sizeof(bytes));
+}
+
+void CopyEncoder::putInt64(int64_t value) {
+  putInt32(static_cast<int32_t>(static_cast<uint64_t>(value) >> 32));
+  putInt32(static_cast<int32_t>(static_cast<uint64_t>(value) & 0xffffffffu));
+}
+
+void CopyEncoder::patchInt32(size_t pos, int32_t value) {
+  uint32_t v = static_cast<uint32_t>(value);
+  buffer_[pos] = static_cast<char>(v >> 24);
+  buffer_[pos + 1] = static_cast<char>(v >> 16);
+  buffer_[pos + 2] = static_cast<char>(v >> 8);
+  buffer_[pos + 3] = static_cast<char>(v);
+}
+
+void CopyEncoder::beginRow(int16_t field_count) {
+  putInt16(field_count);
+  rows_++;
+}
+
+void CopyEncoder::addNull() { putInt32(-1); }
+
+void CopyEncoder::addText(std::string_view value) {
+  putInt32(static_cast<int32_t>(value.size()));
+  buffer_.append(value.data(), value.size());
+}
+
+void CopyEncoder::addTimestamp(std::string_view datestamp) {
+  // OAI-PMH datestamps are YYYY-MM-DD, optionally followed by Thh:mm:ssZ
+  int year, month, day, hour = 0, minute = 0, second = 0;
+  if (!parseField(datestamp, 0, 4, year) ||
+      !parseField(datestamp, 5, 2, month) ||
+      !parseField(datestamp, 8, 2, day)) {
+    addNull();
+    return;
+  }
+  if (datestamp.size() >= 19 &&
+      (!parseField(datestamp, 11, 2, hour) ||
+       !parseField(datestamp, 14, 2, minute) ||
+       !parseField(datestamp, 17, 2, second))) {
+    addNull();
+    return;
+  }
+
+  using namespace std::chrono;
+  year_month_day date{std::chrono::year{year},
+                      std::chrono::month{static_cast<unsigned>(month)},
+                      std::chrono::day{static_cast<unsigned>(day)}};
+  if (!date.ok()) {
+    addNull();
+    return;
+  }
+
+  // Timestamps are microseconds since 2000-01-01 00:00:00
+  constexpr sys_days kPostgresEpoch{std::chrono::year{2000} / January / 1};
+  auto since_epoch = sys_days{date} - kPostgresEpoch + hours{hour} +
+                     minutes{minute} + seconds{second};
+
+  putInt32(8);
+  putInt64(duration_cast<microseconds>(since_epoch).count());
+}
+
+void CopyEncoder::addTextArray(const std::vector<std::string> &values) {
+  // Length is patched once the array body has been written
+  const size_t length_pos = buffer_.size();
+  putInt32(0);
+  const size_t body_start = buffer_.size();
+
+  putInt32(values.empty() ? 0 : 1); // dimensions
+  putInt32(0);                      // has-nulls flag
+  putInt32(kTextOid);
+  if (!values.empty()) {
+    putInt32(static_cast<int32_t>(values.size()));
+    putInt32(1); // lower bound
+    for (const auto &value : values) {
+      addText(value);
+    }
+  }
+
+  patchInt32(length_pos, static_cast<int32_t>(buffer_.size() - body_start));
+}
+
+void CopyEncoder::addJsonb(std::string_view json_text) {
+  putInt32(static_cast<int32_t>(json_text.size() + 1));
+  buffer_.push_back(static_cast<char>(kJsonbVersion));
+  buffer_.append(json_text.data(), json_text.size());
+}
+
+void CopyEncoder::addJsonbArray(const std::vector<std::string> &values) {
+  // Serialize straight into the stream, then patch the length in front
+  const size_t length_pos = buffer_.size();
+  putInt32(0);
+  const size_t body_start = buffer_.size();
+
+  buffer_.push_back(static_cast<char>(kJsonbVersion));
+  JsonHelper::appendStringArray(buffer_, values);
+
+  patchInt32(length_pos, static_cast<int32_t>(buffer_.size() - body_start));
+}
+
+void CopyEncoder::finish() { putInt16(-1); }
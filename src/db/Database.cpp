@@ -7,9 +7,13 @@
 #include "db/Database.h"
 #include "config/Config.h"
 #include "utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 Database::Database() : conn_(nullptr), connected_(false) {}
 
@@ -49,7 +53,11 @@ void Database::connect() {
   conninfo << "password=" << password << " ";
   conninfo << "port=" << port;
 
-  conn_ = PQconnectdb(conninfo.str().c_str());
+  connect(conninfo.str());
+}
+
+void Database::connect(const std::string &conninfo) {
+  conn_ = PQconnectdb(conninfo.c_str());
 
   if (PQstatus(conn_) != CONNECTION_OK) {
     spdlog::error("Failed to connect to PostgreSQL: {}", PQerrorMessage(conn_));
@@ -57,7 +65,7 @@ void Database::connect() {
   }
 
   connected_ = true;
-  spdlog::info("Connected to PostgreSQL database: {}", database);
+  spdlog::info("Connected to PostgreSQL database: {}", PQdb(conn_));
 }
 
 void Database::disconnect() {
@@ -72,6 +80,25 @@ bool Database::isConnected() const {
   return connected_ && conn_ && PQstatus(conn_) == CONNECTION_OK;
 }
 
+void Database::ensureConnected() {
+  if (isConnected()) {
+    return;
+  }
+  if (!conn_) {
+    connect();
+    return;
+  }
+
+  spdlog::warn("PostgreSQL connection lost; reconnecting");
+  PQreset(conn_);
+  if (PQstatus(conn_) != CONNECTION_OK) {
+    spdlog::error("Failed to reconnect to PostgreSQL: {}",
+                  PQerrorMessage(conn_));
+    throw std::runtime_error("Database reconnection failed");
+  }
+  connected_ = true;
+}
+
 void Database::createSchema(const std::string &schema_name) {
   std::string query = "CREATE SCHEMA IF NOT EXISTS " + schema_name;
   execute(query);
@@ -79,55 +106,296 @@ void Database::createSchema(const std::string &schema_name) {
 }
 
 void Database::createTable(const std::string &schema_name,
-                           const std::string &table_name) {
+                           const std::string &table_name,
+                           PartitionScheme scheme, ColumnProfile profile) {
+  const bool partitioned = scheme != PartitionScheme::None;
+  const std::string array_type =
+      profile == ColumnProfile::TextArray ? "TEXT[]" : "JSONB";
+
+  // Unique constraints on a partitioned table must include the partition
+  // key, so identifier uniqueness across partitions is kept by the upsert
+  // (see RecordTable::mergeQuery) rather than by the constraint alone
   std::stringstream query;
   query << "CREATE TABLE IF NOT EXISTS " << schema_name << "." << table_name
         << " ("
-        << "id SERIAL PRIMARY KEY, "
-        << "header_datestamp TIMESTAMP, "
-        << "header_identifier VARCHAR(255) UNIQUE NOT NULL, "
-        << "header_setSpecs JSONB, "
-        << "metadata_creator JSONB, "
-        << "metadata_date JSONB, "
+        << (partitioned ? "id SERIAL, " : "id SERIAL PRIMARY KEY, ")
+        << (partitioned ? "header_datestamp TIMESTAMP NOT NULL, "
+                        : "header_datestamp TIMESTAMP, ")
+        << (partitioned ? "header_identifier VARCHAR(255) NOT NULL, "
+                        : "header_identifier VARCHAR(255) UNIQUE NOT NULL, ")
+        << "header_setSpecs " << array_type << ", "
+        << "metadata_creator " << array_type << ", "
+        << "metadata_date " << array_type << ", "
         << "metadata_description TEXT, "
-        << "metadata_identifier JSONB, "
-        << "metadata_subject JSONB, "
-        << "metadata_title JSONB, "
+        << "metadata_identifier " << array_type << ", "
+        << "metadata_subject " << array_type << ", "
+        << "metadata_title " << array_type << ", "
         << "metadata_type VARCHAR(100), "
         << "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
-        << "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
-        << ")";
+        << "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP";
+  if (partitioned) {
+    query << ", PRIMARY KEY (id, header_datestamp), "
+          << "UNIQUE (header_identifier, header_datestamp)"
+          << ") PARTITION BY RANGE (header_datestamp)";
+  } else {
+    query << ")";
+  }
 
   execute(query.str());
-  spdlog::info("Created table: {}.{}", schema_name, table_name);
+  spdlog::info("Created table: {}.{}{}", schema_name, table_name,
+               partitioned ? " (partitioned by header_datestamp)" : "");
+}
+
+ColumnProfile Database::parseColumnProfile(const std::string &value) {
+  if (value == "textarray") {
+    return ColumnProfile::TextArray;
+  }
+  if (!value.empty() && value != "jsonb") {
+    spdlog::warn("Unknown column profile '{}', using jsonb", value);
+  }
+  return ColumnProfile::Jsonb;
+}
+
+ColumnProfile Database::columnProfile(const std::string &schema_name,
+                                      const std::string &table_name) {
+  PGresult *res = query("SELECT data_type FROM information_schema.columns "
+                        "WHERE table_schema = $1 AND table_name = $2 "
+                        "AND column_name = 'header_setspecs'",
+                        {schema_name.c_str(), table_name.c_str()});
+  bool text_array =
+      PQntuples(res) > 0 && std::string(PQgetvalue(res, 0, 0)) == "ARRAY";
+  PQclear(res);
+  return text_array ? ColumnProfile::TextArray : ColumnProfile::Jsonb;
+}
+
+PartitionScheme Database::parsePartitionScheme(const std::string &value) {
+  if (value == "yearly") {
+    return PartitionScheme::Yearly;
+  }
+  if (value == "monthly") {
+    return PartitionScheme::Monthly;
+  }
+  if (!value.empty() && value != "none") {
+    spdlog::warn("Unknown partitioning scheme '{}', using none", value);
+  }
+  return PartitionScheme::None;
+}
+
+bool Database::isPartitioned(const std::string &schema_name,
+                             const std::string &table_name) {
+  PGresult *res = query("SELECT c.relkind FROM pg_class c "
+                        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                        "WHERE n.nspname = $1 AND c.relname = $2",
+                        {schema_name.c_str(), table_name.c_str()});
+  bool partitioned = PQntuples(res) > 0 && PQgetvalue(res, 0, 0)[0] == 'p';
+  PQclear(res);
+  return partitioned;
+}
+
+bool Database::tableExists(const std::string &schema_name,
+                           const std::string &table_name) {
+  PGresult *res = query("SELECT 1 FROM pg_class c "
+                        "JOIN pg_namespace n ON n.oid = c.relnamespace "
+                        "WHERE n.nspname = $1 AND c.relname = $2",
+                        {schema_name.c_str(), table_name.c_str()});
+  bool exists = PQntuples(res) > 0;
+  PQclear(res);
+  return exists;
+}
+
+void Database::ensurePartitions(const std::string &schema_name,
+                                const std::string &table_name,
+                                PartitionScheme scheme,
+                                const std::vector<std::string> &datestamps) {
+  if (scheme == PartitionScheme::None) {
+    return;
+  }
+
+  // Datestamps start with YYYY-MM; the key is the year or the year-month
+  const size_t key_length = scheme == PartitionScheme::Yearly ? 4 : 7;
+
+  std::set<std::string> keys;
+  for (const auto &datestamp : datestamps) {
+    if (datestamp.size() >= key_length) {
+      keys.insert(datestamp.substr(0, key_length));
+    }
+  }
+
+  for (const auto &key : keys) {
+    if (known_partitions_.count(key)) {
+      continue;
+    }
+
+    int year = std::stoi(key.substr(0, 4));
+    int month = scheme == PartitionScheme::Monthly ? std::stoi(key.substr(5, 2))
+                                                   : 1;
+    int next_year = scheme == PartitionScheme::Yearly ? year + 1
+                    : month == 12                     ? year + 1
+                                                      : year;
+    int next_month = scheme == PartitionScheme::Yearly ? 1 : month % 12 + 1;
+
+    char name_suffix[32], lower[32], upper[32];
+    if (scheme == PartitionScheme::Yearly) {
+      snprintf(name_suffix, sizeof(name_suffix), "y%04d", year);
+    } else {
+      snprintf(name_suffix, sizeof(name_suffix), "m%04d_%02d", year, month);
+    }
+    snprintf(lower, sizeof(lower), "%04d-%02d-01", year, month);
+    snprintf(upper, sizeof(upper), "%04d-%02d-01", next_year, next_month);
+
+    execute("CREATE TABLE IF NOT EXISTS " + schema_name + "." + table_name +
+            "_" + name_suffix + " PARTITION OF " + schema_name + "." +
+            table_name + " FOR VALUES FROM ('" + lower + "') TO ('" + upper +
+            "')");
+    known_partitions_.insert(key);
+    spdlog::debug("Ensured partition {}_{}", table_name, name_suffix);
+  }
+}
+
+void Database::freezePartitionsBefore(const std::string &schema_name,
+                                      const std::string &table_name,
+                                      const std::string &cutoff_date) {
+  // Partitions whose upper bound is at or before the cutoff only receive
+  // deletes from records whose datestamp moved forward; freezing them once
+  // lets later (anti-wraparound) vacuums skip every page
+  PGresult *res = query(
+      "SELECT child.relname FROM pg_inherits i "
+      "JOIN pg_class parent ON parent.oid = i.inhparent "
+      "JOIN pg_namespace n ON n.oid = parent.relnamespace "
+      "JOIN pg_class child ON child.oid = i.inhrelid "
+      "WHERE n.nspname = $1 AND parent.relname = $2 "
+      "AND (regexp_match(pg_get_expr(child.relpartbound, child.oid), "
+      "'TO \\(''([^'']+)''\\)'))[1]::timestamp <= $3::timestamp "
+      "ORDER BY child.relname",
+      {schema_name.c_str(), table_name.c_str(), cutoff_date.c_str()});
+
+  std::vector<std::string> partitions;
+  for (int i = 0; i < PQntuples(res); ++i) {
+    partitions.emplace_back(PQgetvalue(res, i, 0));
+  }
+  PQclear(res);
+
+  for (const auto &partition : partitions) {
+    execute("VACUUM (FREEZE, ANALYZE) " + schema_name + "." + partition);
+    spdlog::info("Froze partition {}.{}", schema_name, partition);
+  }
+  spdlog::info("Froze {} partitions of {}.{} before {}", partitions.size(),
+               schema_name, table_name, cutoff_date);
+}
+
+std::vector<std::pair<std::string, std::string>>
+Database::secondaryIndexes(const std::string &schema_name,
+                           const std::string &table_name) {
+  const std::string target = schema_name + "." + table_name;
+  return {
+      {table_name + "_header_datestamp_idx",
+       "ON " + target + " (header_datestamp)"},
+      {table_name + "_header_setspecs_idx",
+       "ON " + target + " USING GIN (header_setSpecs)"},
+      {table_name + "_header_datestamp_setspecs_idx",
+       "ON " + target + " (header_datestamp, header_setSpecs)"},
+      {table_name + "_metadata_subject_idx",
+       "ON " + target + " USING GIN (metadata_subject)"},
+      {table_name + "_created_at_idx", "ON " + target + " (created_at)"},
+      {table_name + "_updated_at_idx", "ON " + target + " (updated_at)"}};
 }
 
 void Database::createIndexes(const std::string &schema_name,
                              const std::string &table_name) {
-  std::vector<std::string> indexes = {
-      "CREATE UNIQUE INDEX IF NOT EXISTS " + table_name +
-          "_header_identifier_idx ON " + schema_name + "." + table_name +
-          " (header_identifier)",
-      "CREATE INDEX IF NOT EXISTS " + table_name + "_header_datestamp_idx ON " +
-          schema_name + "." + table_name + " (header_datestamp)",
-      "CREATE INDEX IF NOT EXISTS " + table_name + "_header_setspecs_idx ON " +
-          schema_name + "." + table_name + " USING GIN (header_setSpecs)",
-      "CREATE INDEX IF NOT EXISTS " + table_name +
-          "_header_datestamp_setspecs_idx ON " + schema_name + "." +
-          table_name + " (header_datestamp, header_setSpecs)",
-      "CREATE INDEX IF NOT EXISTS " + table_name + "_metadata_subject_idx ON " +
-          schema_name + "." + table_name + " USING GIN (metadata_subject)",
-      "CREATE INDEX IF NOT EXISTS " + table_name + "_created_at_idx ON " +
-          schema_name + "." + table_name + " (created_at)",
-      "CREATE INDEX IF NOT EXISTS " + table_name + "_updated_at_idx ON " +
-          schema_name + "." + table_name + " (updated_at)"};
-
-  for (const auto &idx : indexes) {
-    execute(idx);
+  // header_identifier is already covered by the index behind its UNIQUE
+  // constraint; drop the redundant copy older versions created
+  execute("DROP INDEX IF EXISTS " + schema_name + "." + table_name +
+          "_header_identifier_idx");
+
+  for (const auto &[name, definition] :
+       secondaryIndexes(schema_name, table_name)) {
+    execute("CREATE INDEX IF NOT EXISTS " + name + " " + definition);
   }
   spdlog::info("Created indexes for table: {}.{}", schema_name, table_name);
 }
 
+void Database::dropSecondaryIndexes(const std::string &schema_name,
+                                    const std::string &table_name) {
+  execute("DROP INDEX IF EXISTS " + schema_name + "." + table_name +
+          "_header_identifier_idx");
+
+  for (const auto &[name, definition] :
+       secondaryIndexes(schema_name, table_name)) {
+    execute("DROP INDEX IF EXISTS " + schema_name + "." + name);
+  }
+  spdlog::info("Dropped secondary indexes for bulk load: {}.{}", schema_name,
+               table_name);
+}
+
+void Database::buildIndexesParallel(const std::string &schema_name,
+                                    const std::string &table_name,
+                                    int workers) {
+  const auto indexes = secondaryIndexes(schema_name, table_name);
+  const size_t worker_count = std::clamp<size_t>(
+      workers > 0 ? static_cast<size_t>(workers) : 1, 1, indexes.size());
+
+  spdlog::info("Building {} indexes for {}.{} on {} connections",
+               indexes.size(), schema_name, table_name, worker_count);
+
+  // Each worker owns a connection and pulls the next index off a shared
+  // counter. Plain CREATE INDEX takes a SHARE lock, which does not conflict
+  // with itself, so the builds really run side by side; CREATE INDEX
+  // CONCURRENTLY would serialize on its SHARE UPDATE EXCLUSIVE lock.
+  std::atomic<size_t> next{0};
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+
+  for (size_t w = 0; w < worker_count; ++w) {
+    threads.emplace_back([&]() {
+      try {
+        Database worker;
+        worker.connect();
+        worker.execute("SET maintenance_work_mem = '1GB'");
+
+        for (size_t i = next++; i < indexes.size(); i = next++) {
+          const auto &[name, definition] = indexes[i];
+          auto started = std::chrono::steady_clock::now();
+          try {
+            worker.execute("CREATE INDEX IF NOT EXISTS " + name + " " +
+                           definition);
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - started);
+            spdlog::info("Built index {} in {} seconds", name,
+                         elapsed.count());
+          } catch (const std::exception &e) {
+            failures++;
+            spdlog::error("Failed to build index {}: {}", name, e.what());
+          }
+        }
+      } catch (const std::exception &e) {
+        failures++;
+        spdlog::error("Index worker failed: {}", e.what());
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (failures > 0) {
+    throw std::runtime_error("Index build failed");
+  }
+
+  execute("ANALYZE " + schema_name + "." + table_name);
+  spdlog::info("Built indexes and analyzed table: {}.{}", schema_name,
+               table_name);
+}
+
+std::string Database::setSpecMatch(ColumnProfile profile,
+                                   const std::string &param) {
+  const std::string elements = profile == ColumnProfile::TextArray
+                                   ? "unnest(header_setSpecs)"
+                                   : "jsonb_array_elements_text(header_setSpecs)";
+  return "EXISTS (SELECT 1 FROM " + elements + " AS s(spec) WHERE s.spec = " +
+         param + "::text OR s.spec LIKE " + param + "::text || ':%')";
+}
+
 void Database::execute(const std::string &query) {
   PGresult *res = PQexec(conn_, query.c_str());
 
@@ -153,3 +421,74 @@ PGresult *Database::query(const std::string &query) {
 
   return res;
 }
+
+void Database::execute(const std::string &query,
+                       const std::vector<const char *> &params) {
+  PGresult *res =
+      PQexecParams(conn_, query.c_str(), static_cast<int>(params.size()),
+                   nullptr, params.data(), nullptr, nullptr, 0);
+
+  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    spdlog::error("Query failed: {}", PQerrorMessage(conn_));
+    spdlog::error("Query: {}", query);
+    PQclear(res);
+    throw std::runtime_error("Query execution failed");
+  }
+
+  PQclear(res);
+}
+
+PGresult *Database::query(const std::string &query,
+                          const std::vector<const char *> &params) {
+  PGresult *res =
+      PQexecParams(conn_, query.c_str(), static_cast<int>(params.size()),
+                   nullptr, params.data(), nullptr, nullptr, 0);
+
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+    spdlog::error("Query failed: {}", PQerrorMessage(conn_));
+    spdlog::error("Query: {}", query);
+    PQclear(res);
+    throw std::runtime_error("Query execution failed");
+  }
+
+  return res;
+}
+
+void Database::copyFrom(const std::string &copy_query,
+                        const std::string &data) {
+  PGresult *res = PQexec(conn_, copy_query.c_str());
+  if (PQresultStatus(res) != PGRES_COPY_IN) {
+    spdlog::error("COPY failed to start: {}", PQerrorMessage(conn_));
+    spdlog::error("Query: {}", copy_query);
+    PQclear(res);
+    throw std::runtime_error("COPY failed");
+  }
+  PQclear(res);
+
+  // libpq buffers internally; hand the payload over in bounded chunks
+  constexpr size_t chunk_size = 1 << 20;
+  bool sent = true;
+  for (size_t offset = 0; offset < data.size() && sent;
+       offset += chunk_size) {
+    size_t length = std::min(chunk_size, data.size() - offset);
+    sent = PQputCopyData(conn_, data.data() + offset,
+                         static_cast<int>(length)) == 1;
+  }
+
+  if (PQputCopyEnd(conn_, sent ? nullptr : "client send failed") != 1) {
+    sent = false;
+  }
+
+  bool ok = sent;
+  while ((res = PQgetResult(conn_)) != nullptr) {
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+      ok = false;
+    }
+    PQclear(res);
+  }
+
+  if (!ok) {
+    spdlog::error("COPY failed: {}", PQerrorMessage(conn_));
+    throw std::runtime_error("COPY failed");
+  }
+}
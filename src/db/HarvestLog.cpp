@@ -0,0 +1,129 @@
+/**
+ * @file HarvestLog.cpp
+ * @brief Per-set, per-day harvest coverage ledger implementation
+ * @author Bernard Chase
+ */
+
+#include "db/HarvestLog.h"
+#include "utils/Logger.h"
+
+HarvestLog::HarvestLog(Database &db) : db_(db) {}
+
+void HarvestLog::useTable(const std::string &schema_name,
+                          const std::string &prefix) {
+  table_ = schema_name + "." + prefix + "harvest_log";
+}
+
+void HarvestLog::ensureTable(const std::string &schema_name,
+                             const std::string &prefix) {
+  useTable(schema_name, prefix);
+
+  db_.execute("CREATE TABLE IF NOT EXISTS " + table_ +
+              " ("
+              "set_spec VARCHAR(100) NOT NULL, "
+              "day DATE NOT NULL, "
+              "status VARCHAR(20) NOT NULL, "
+              "record_count INTEGER NOT NULL DEFAULT 0, "
+              "page_count INTEGER NOT NULL DEFAULT 0, "
+              "complete_list_size BIGINT, "
+              "window_start DATE, "
+              "window_end DATE, "
+              "fetched_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+              "PRIMARY KEY (set_spec, day)"
+              ")");
+}
+
+void HarvestLog::recordComplete(const HarvestWindow &window) {
+  // Per-day counts travel as two parallel arrays and are spread over the
+  // window's calendar on the server, so the whole window is one statement
+  std::string days = "{";
+  std::string counts = "{";
+  for (const auto &[day, count] : window.day_counts) {
+    if (days.size() > 1) {
+      days += ",";
+      counts += ",";
+    }
+    days += day;
+    counts += std::to_string(count);
+  }
+  days += "}";
+  counts += "}";
+
+  std::string pages = std::to_string(window.pages);
+  std::string list_size = std::to_string(window.complete_list_size);
+
+  db_.execute(
+      "INSERT INTO " + table_ +
+          " (set_spec, day, status, record_count, page_count, "
+          "complete_list_size, window_start, window_end, fetched_at) "
+          "SELECT $1, d::date, 'complete', COALESCE(c.n, 0), $4, "
+          "NULLIF($5::bigint, -1), $2::date, $3::date, CURRENT_TIMESTAMP "
+          "FROM generate_series($2::timestamp, $3::timestamp, "
+          "interval '1 day') AS d "
+          "LEFT JOIN unnest($6::date[], $7::int[]) AS c(day, n) "
+          "ON c.day = d::date "
+          "ON CONFLICT (set_spec, day) DO UPDATE SET "
+          "status = EXCLUDED.status, "
+          "record_count = EXCLUDED.record_count, "
+          "page_count = EXCLUDED.page_count, "
+          "complete_list_size = EXCLUDED.complete_list_size, "
+          "window_start = EXCLUDED.window_start, "
+          "window_end = EXCLUDED.window_end, "
+          "fetched_at = EXCLUDED.fetched_at",
+      {window.set_spec.c_str(), window.from_date.c_str(),
+       window.until_date.c_str(), pages.c_str(), list_size.c_str(),
+       days.c_str(), counts.c_str()});
+
+  spdlog::debug("Logged window {} {}..{}: {} pages", window.set_spec,
+                window.from_date, window.until_date, window.pages);
+}
+
+void HarvestLog::recordStarted(const std::string &set_spec,
+                               const std::string &from_date,
+                               const std::string &until_date) {
+  recordStatus(set_spec, from_date, until_date, "running");
+}
+
+void HarvestLog::recordFailed(const std::string &set_spec,
+                              const std::string &from_date,
+                              const std::string &until_date) {
+  recordStatus(set_spec, from_date, until_date, "failed");
+}
+
+void HarvestLog::recordStatus(const std::string &set_spec,
+                              const std::string &from_date,
+                              const std::string &until_date,
+                              const char *status) {
+  // Never downgrade a day that an earlier run already completed
+  db_.execute("INSERT INTO " + table_ +
+                  " (set_spec, day, status, window_start, window_end, "
+                  "fetched_at) "
+                  "SELECT $1, d::date, $4, $2::date, $3::date, "
+                  "CURRENT_TIMESTAMP "
+                  "FROM generate_series($2::timestamp, $3::timestamp, "
+                  "interval '1 day') AS d "
+                  "ON CONFLICT (set_spec, day) DO UPDATE SET "
+                  "status = EXCLUDED.status, "
+                  "window_start = EXCLUDED.window_start, "
+                  "window_end = EXCLUDED.window_end, "
+                  "fetched_at = EXCLUDED.fetched_at "
+                  "WHERE " +
+                  table_ + ".status <> 'complete'",
+              {set_spec.c_str(), from_date.c_str(), until_date.c_str(),
+               status});
+}
+
+bool HarvestLog::coveredSince(const std::string &set_spec,
+                              const std::string &from_date,
+                              const std::string &until_date,
+                              const std::string &since) {
+  PGresult *res = db_.query(
+      "SELECT count(*) = ($3::date - $2::date + 1) FROM " + table_ +
+          " WHERE set_spec = $1 AND day BETWEEN $2::date AND $3::date "
+          "AND status = 'complete' AND fetched_at >= $4::timestamptz",
+      {set_spec.c_str(), from_date.c_str(), until_date.c_str(),
+       since.c_str()});
+  bool covered = std::string(PQgetvalue(res, 0, 0)) == "t";
+  PQclear(res);
+  return covered;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file JobQueue.cpp
+ * @brief Shared queue of harvest windows for multi-node workers implementation
+ * @author Bernard Chase
+ */
+
+#include "db/JobQueue.h"
+#include "config/Config.h"
+#include "utils/Logger.h"
+#include <cstdio>
+#include <unistd.h>
+
+JobQueue::JobQueue(Database &db) : db_(db) {}
+
+void JobQueue::ensureTable(const std::string &schema_name) {
+  table_ = schema_name + ".harvest_jobs";
+
+  db_.execute("CREATE TABLE IF NOT EXISTS " + table_ +
+              " ("
+              "id BIGSERIAL PRIMARY KEY, "
+              "repository VARCHAR(100) NOT NULL, "
+              "set_spec VARCHAR(100) NOT NULL, "
+              "from_date DATE NOT NULL, "
+              "until_date DATE NOT NULL, "
+              "status VARCHAR(20) NOT NULL DEFAULT 'pending', "
+              "attempts INTEGER NOT NULL DEFAULT 0, "
+              "worker TEXT, "
+              "lease_until TIMESTAMPTZ, "
+              "last_error TEXT, "
+              "created_at TIMESTAMPTZ DEFAULT now(), "
+              "updated_at TIMESTAMPTZ DEFAULT now(), "
+              "UNIQUE (repository, set_spec, from_date, until_date)"
+              ")");
+
+  // Claims scan only unfinished jobs
+  db_.execute("CREATE INDEX IF NOT EXISTS harvest_jobs_claim_idx ON " +
+              table_ +
+              " (repository, id) WHERE status IN ('pending', 'running')");
+}
+
+bool JobQueue::enqueue(const std::string &repository,
+                       const std::string &set_spec,
+                       const std::string &from_date,
+                       const std::string &until_date) {
+  PGresult *res = db_.query(
+      "INSERT INTO " + table_ +
+          " (repository, set_spec, from_date, until_date) "
+          "SELECT $1, $2, $3::date, $4::date WHERE NOT EXISTS ("
+          "SELECT 1 FROM " + table_ +
+          " WHERE repository = $1 AND set_spec = $2 "
+          "AND status IN ('pending', 'running') "
+          "AND daterange(from_date, until_date, '[]') && "
+          "daterange($3::date, $4::date, '[]')) "
+          "ON CONFLICT (repository, set_spec, from_date, until_date) DO UPDATE "
+          "SET status = 'pending', attempts = 0, worker = NULL, "
+          "lease_until = NULL, updated_at = now() "
+          "WHERE " + table_ + ".status IN ('done', 'failed') "
+          "RETURNING id",
+      {repository.c_str(), set_spec.c_str(), from_date.c_str(),
+       until_date.c_str()});
+  bool added = PQntuples(res) > 0;
+  PQclear(res);
+  return added;
+}
+
+std::optional<HarvestJob> JobQueue::claim(const std::string &repository,
+                                          const std::string &worker,
+                                          int lease_seconds,
+                                          int max_attempts) {
+  std::string lease = std::to_string(lease_seconds);
+  std::string attempts = std::to_string(max_attempts);
+
+  // A worker lost on its last attempt leaves a running job that no claim
+  // may take; fail it so it stops blocking enqueue of overlapping windows
+  db_.execute("UPDATE " + table_ +
+                  " SET status = 'failed', lease_until = NULL, "
+                  "last_error = 'lease expired on final attempt', "
+                  "updated_at = now() "
+                  "WHERE repository = $1 AND status = 'running' "
+                  "AND lease_until < now() AND attempts >= $2::int",
+              {repository.c_str(), attempts.c_str()});
+
+  // The inner SELECT locks one candidate row and skips rows other workers
+  // are claiming right now; the UPDATE then takes it over
+  PGresult *res = db_.query(
+      "UPDATE " + table_ +
+          " SET status = 'running', worker = $2, attempts = attempts + 1, "
+          "lease_until = now() + make_interval(secs => $3::int), "
+          "updated_at = now() "
+          "WHERE id = (SELECT id FROM " + table_ +
+          " WHERE repository = $1 AND attempts < $4::int AND "
+          "(status = 'pending' OR "
+          "(status = 'running' AND lease_until < now())) "
+          "ORDER BY id LIMIT 1 FOR UPDATE SKIP LOCKED) "
+          "RETURNING id, set_spec, to_char(from_date, 'YYYY-MM-DD'), "
+          "to_char(until_date, 'YYYY-MM-DD'), attempts",
+      {repository.c_str(), worker.c_str(), lease.c_str(), attempts.c_str()});
+
+  std::optional<HarvestJob> job;
+  if (PQntuples(res) > 0) {
+    job.emplace();
+    job->id = std::stol(PQgetvalue(res, 0, 0));
+    job->repository = repository;
+    job->set_spec = PQgetvalue(res, 0, 1);
+    job->from_date = PQgetvalue(res, 0, 2);
+    job->until_date = PQgetvalue(res, 0, 3);
+    job->attempts = std::stoi(PQgetvalue(res, 0, 4));
+  }
+  PQclear(res);
+  return job;
+}
+
+bool JobQueue::heartbeat(long id, const std::string &worker,
+                         int lease_seconds) {
+  std::string job_id = std::to_string(id);
+  std::string lease = std::to_string(lease_seconds);
+
+  PGresult *res = db_.query(
+      "UPDATE " + table_ +
+          " SET lease_until = now() + make_interval(secs => $3::int), "
+          "updated_at = now() "
+          "WHERE id = $1::bigint AND worker = $2 AND status = 'running' "
+          "RETURNING id",
+      {job_id.c_str(), worker.c_str(), lease.c_str()});
+  bool held = PQntuples(res) > 0;
+  PQclear(res);
+  return held;
+}
+
+void JobQueue::complete(long id, const std::string &worker) {
+  std::string job_id = std::to_string(id);
+  db_.execute("UPDATE " + table_ +
+                  " SET status = 'done', lease_until = NULL, "
+                  "last_error = NULL, updated_at = now() "
+                  "WHERE id = $1::bigint AND worker = $2",
+              {job_id.c_str(), worker.c_str()});
+}
+
+void JobQueue::fail(long id, const std::string &worker,
+                    const std::string &error, int max_attempts) {
+  std::string job_id = std::to_string(id);
+  std::string attempts = std::to_string(max_attempts);
+  db_.execute("UPDATE " + table_ +
+                  " SET status = CASE WHEN attempts >= $4::int "
+                  "THEN 'failed' ELSE 'pending' END, "
+                  "lease_until = NULL, last_error = $3, updated_at = now() "
+                  "WHERE id = $1::bigint AND worker = $2",
+              {job_id.c_str(), worker.c_str(), error.c_str(),
+               attempts.c_str()});
+}
+
+void JobQueue::release(long id, const std::string &worker) {
+  std::string job_id = std::to_string(id);
+  db_.execute("UPDATE " + table_ +
+                  " SET status = 'pending', attempts = attempts - 1, "
+                  "lease_until = NULL, updated_at = now() "
+                  "WHERE id = $1::bigint AND worker = $2 "
+                  "AND status = 'running'",
+              {job_id.c_str(), worker.c_str()});
+}
+
+std::map<std::string, long> JobQueue::counts(const std::string &repository) {
+  PGresult *res = db_.query("SELECT status, count(*) FROM " + table_ +
+                                " WHERE repository = $1 GROUP BY status",
+                            {repository.c_str()});
+  std::map<std::string, long> counts;
+  for (int i = 0; i < PQntuples(res); ++i) {
+    counts[PQgetvalue(res, i, 0)] = std::stol(PQgetvalue(res, i, 1));
+  }
+  PQclear(res);
+  return counts;
+}
+
+std::string JobQueue::defaultWorkerId() {
+  std::string configured = Config::instance().getWorkerId();
+  if (!configured.empty()) {
+    return configured;
+  }
+  char host[256] = {0};
+  if (gethostname(host, sizeof(host) - 1) != 0) {
+    std::snprintf(host, sizeof(host), "unknown");
+  }
+  return std::string(host) + ":" + std::to_string(getpid());
+}
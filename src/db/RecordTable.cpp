@@ -0,0 +1,102 @@
+/**
+ * @file RecordTable.cpp
+ * @brief Row layout and upsert of the metadata table implementation
+ * @author Bernard Chase
+ */
+
+#include "db/RecordTable.h"
+
+const std::string &RecordTable::columns() {
+  static const std::string columns = R"(
+            header_datestamp, header_identifier, header_setSpecs,
+            metadata_creator, metadata_date, metadata_description,
+            metadata_identifier, metadata_subject, metadata_title, metadata_type)";
+  return columns;
+}
+
+void RecordTable::encode(CopyEncoder &encoder, const Record &record,
+                         ColumnProfile profile) {
+  encoder.beginRow(10);
+  encoder.addTimestamp(record.header_datestamp);
+  encoder.addText(record.header_identifier);
+
+  if (profile == ColumnProfile::TextArray) {
+    encoder.addTextArray(record.header_setSpecs);
+    encoder.addTextArray(record.metadata_creator);
+    encoder.addTextArray(record.metadata_date);
+    encoder.addText(record.metadata_description);
+    encoder.addTextArray(record.metadata_identifier);
+    encoder.addTextArray(record.metadata_subject);
+    encoder.addTextArray(record.metadata_title);
+  } else {
+    encoder.addJsonbArray(record.header_setSpecs);
+    encoder.addJsonbArray(record.metadata_creator);
+    encoder.addJsonbArray(record.metadata_date);
+    encoder.addText(record.metadata_description);
+    encoder.addJsonbArray(record.metadata_identifier);
+    encoder.addJsonbArray(record.metadata_subject);
+    encoder.addJsonbArray(record.metadata_title);
+  }
+
+  encoder.addText(record.metadata_type);
+}
+
+std::string RecordTable::mergeQuery(const std::string &target,
+                                    const std::string &source,
+                                    PartitionScheme scheme) {
+  const std::string &cols = columns();
+
+  const std::string update_clause = R"(
+        DO UPDATE SET
+            header_datestamp = EXCLUDED.header_datestamp,
+            header_setSpecs = EXCLUDED.header_setSpecs,
+            metadata_creator = EXCLUDED.metadata_creator,
+            metadata_date = EXCLUDED.metadata_date,
+            metadata_description = EXCLUDED.metadata_description,
+            metadata_identifier = EXCLUDED.metadata_identifier,
+            metadata_subject = EXCLUDED.metadata_subject,
+            metadata_title = EXCLUDED.metadata_title,
+            metadata_type = EXCLUDED.metadata_type,
+            updated_at = CURRENT_TIMESTAMP
+    )";
+
+  // DISTINCT ON keeps the upsert from touching the same row twice if the
+  // source repeats an identifier
+  if (scheme == PartitionScheme::None) {
+    return R"(
+        INSERT INTO )" + target + R"( ()" + cols + R"(
+        )
+        SELECT DISTINCT ON (header_identifier) )" +
+           cols + R"(
+        FROM )" + source + R"(
+        ORDER BY header_identifier, header_datestamp DESC
+        ON CONFLICT (header_identifier) )" +
+           update_clause;
+  }
+
+  // A new datestamp moves the record to another partition: delete the old
+  // row first and carry its created_at over to the new one
+  return R"(
+        WITH batch AS (
+            SELECT DISTINCT ON (header_identifier) *
+            FROM )" + source + R"(
+            ORDER BY header_identifier, header_datestamp DESC
+        ), moved AS (
+            DELETE FROM )" + target + R"( t
+            USING batch b
+            WHERE t.header_identifier = b.header_identifier
+              AND t.header_datestamp <> b.header_datestamp
+            RETURNING t.header_identifier, t.created_at
+        )
+        INSERT INTO )" + target + R"( ()" + cols + R"(,
+            created_at
+        )
+        SELECT b.header_datestamp, b.header_identifier, b.header_setSpecs,
+            b.metadata_creator, b.metadata_date, b.metadata_description,
+            b.metadata_identifier, b.metadata_subject, b.metadata_title,
+            b.metadata_type, COALESCE(m.created_at, CURRENT_TIMESTAMP)
+        FROM batch b
+        LEFT JOIN moved m ON m.header_identifier = b.header_identifier
+        ON CONFLICT (header_identifier, header_datestamp) )" +
+         update_clause;
+}
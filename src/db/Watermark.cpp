@@ -0,0 +1,58 @@
+/**
+ * @file Watermark.cpp
+ * @brief Per-set high-water marks for incremental harvesting implementation
+ * @author Bernard Chase
+ */
+
+#include "db/Watermark.h"
+#include "utils/Logger.h"
+
+Watermarks::Watermarks(Database &db) : db_(db) {}
+
+void Watermarks::ensureTable(const std::string &schema_name,
+                             const std::string &prefix) {
+  table_ = schema_name + "." + prefix + "harvest_watermark";
+
+  db_.execute("CREATE TABLE IF NOT EXISTS " + table_ +
+              " ("
+              "set_spec VARCHAR(100) PRIMARY KEY, "
+              "high_water DATE NOT NULL, "
+              "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+              ")");
+}
+
+std::string Watermarks::get(const std::string &set_spec) {
+  PGresult *res = db_.query("SELECT to_char(high_water, 'YYYY-MM-DD') FROM " +
+                                table_ + " WHERE set_spec = $1",
+                            {set_spec.c_str()});
+  std::string day;
+  if (PQntuples(res) > 0) {
+    day = PQgetvalue(res, 0, 0);
+  }
+  PQclear(res);
+  return day;
+}
+
+void Watermarks::advance(const std::vector<std::string> &set_specs,
+                         const std::string &day) {
+  std::string sets = "{";
+  for (const auto &set_spec : set_specs) {
+    if (sets.size() > 1) {
+      sets += ",";
+    }
+    sets += "\"" + set_spec + "\"";
+  }
+  sets += "}";
+
+  db_.execute("INSERT INTO " + table_ +
+                  " (set_spec, high_water, updated_at) "
+                  "SELECT s, $2::date, CURRENT_TIMESTAMP "
+                  "FROM unnest($1::text[]) AS s "
+                  "ON CONFLICT (set_spec) DO UPDATE SET "
+                  "high_water = GREATEST(" + table_ + ".high_water, "
+                  "EXCLUDED.high_water), "
+                  "updated_at = EXCLUDED.updated_at",
+              {sets.c_str(), day.c_str()});
+
+  spdlog::debug("Watermark for {} sets advanced to {}", set_specs.size(), day);
+}
@@ -0,0 +1,175 @@
+/**
+ * @file Archive.cpp
+ * @brief On-disk archive of raw OAI-PMH response pages implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/Archive.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <tuple>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// The set-less lane has no set name; "_all" cannot clash with a setSpec
+const char *kAllSets = "_all";
+
+std::string pageName(int page) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "page-%05d.xml", page);
+  return name;
+}
+
+} // namespace
+
+std::vector<std::string> ArchiveWindow::pageFiles() const {
+  std::vector<std::string> files;
+  for (int page = 1; page <= pages; ++page) {
+    files.push_back((fs::path(path) / pageName(page)).string());
+  }
+  return files;
+}
+
+PageArchive::PageArchive(std::string root) : root_(std::move(root)) {}
+
+std::string PageArchive::windowPath(const std::string &repository,
+                                    const std::string &set_spec,
+                                    const std::string &month) const {
+  return (fs::path(root_) / repository /
+          (set_spec.empty() ? kAllSets : set_spec) / month)
+      .string();
+}
+
+std::optional<ArchiveWindow>
+PageArchive::readManifest(const std::string &path) {
+  std::ifstream file(fs::path(path) / "manifest.json");
+  if (!file.is_open()) {
+    return std::nullopt;
+  }
+  json manifest = json::parse(file, nullptr, false);
+  if (manifest.is_discarded()) {
+    spdlog::warn("Ignoring archive window with unreadable manifest: {}", path);
+    return std::nullopt;
+  }
+
+  ArchiveWindow window;
+  window.repository = manifest.value("repository", "");
+  window.set_spec = manifest.value("set_spec", "");
+  window.from_date = manifest.value("from", "");
+  window.until_date = manifest.value("until", "");
+  window.pages = manifest.value("pages", 0);
+  window.records = manifest.value("records", 0L);
+  window.complete_list_size = manifest.value("complete_list_size", -1L);
+  window.fetched_at = manifest.value("fetched_at", "");
+  window.path = path;
+  return window;
+}
+
+std::optional<ArchiveWindow>
+PageArchive::find(const std::string &repository, const std::string &set_spec,
+                  const std::string &month) const {
+  return readManifest(windowPath(repository, set_spec, month));
+}
+
+std::vector<ArchiveWindow>
+PageArchive::list(const std::string &repository) const {
+  std::vector<ArchiveWindow> windows;
+  fs::path base = fs::path(root_) / repository;
+  if (!fs::is_directory(base)) {
+    return windows;
+  }
+
+  for (const auto &lane : fs::directory_iterator(base)) {
+    if (!lane.is_directory()) {
+      continue;
+    }
+    for (const auto &month : fs::directory_iterator(lane.path())) {
+      // Staging directories start with a dot and have no manifest yet
+      if (month.is_directory() &&
+          month.path().filename().string().front() != '.') {
+        if (auto window = readManifest(month.path().string())) {
+          windows.push_back(std::move(*window));
+        }
+      }
+    }
+  }
+
+  std::sort(windows.begin(), windows.end(),
+            [](const ArchiveWindow &a, const ArchiveWindow &b) {
+              return std::tie(a.set_spec, a.from_date) <
+                     std::tie(b.set_spec, b.from_date);
+            });
+  return windows;
+}
+
+PageArchive::Writer::Writer(const PageArchive &archive, ArchiveWindow window)
+    : window_(std::move(window)), committed_(false) {
+  window_.path = archive.windowPath(window_.repository, window_.set_spec,
+                                    window_.from_date.substr(0, 7));
+  window_.pages = 0;
+  window_.records = 0;
+
+  fs::path target(window_.path);
+  staging_ = (target.parent_path() / ("." + target.filename().string() +
+                                      ".partial"))
+                 .string();
+  fs::remove_all(staging_);
+  fs::create_directories(staging_);
+}
+
+PageArchive::Writer::~Writer() {
+  if (!committed_) {
+    std::error_code ignored;
+    fs::remove_all(staging_, ignored);
+  }
+}
+
+void PageArchive::Writer::addPage(const std::string &xml, long records) {
+  window_.pages++;
+  window_.records += records;
+
+  std::ofstream out(fs::path(staging_) / pageName(window_.pages),
+                    std::ios::binary);
+  out.write(xml.data(), static_cast<std::streamsize>(xml.size()));
+  if (!out) {
+    throw std::runtime_error("Cannot write archive page in " + staging_);
+  }
+}
+
+void PageArchive::Writer::commit(long complete_list_size) {
+  std::time_t now = std::time(nullptr);
+  char fetched_at[32];
+  std::strftime(fetched_at, sizeof(fetched_at), "%Y-%m-%dT%H:%M:%SZ",
+                std::gmtime(&now));
+
+  json manifest = {{"repository", window_.repository},
+                   {"set_spec", window_.set_spec},
+                   {"from", window_.from_date},
+                   {"until", window_.until_date},
+                   {"pages", window_.pages},
+                   {"records", window_.records},
+                   {"complete_list_size", complete_list_size},
+                   {"fetched_at", fetched_at}};
+  {
+    std::ofstream out(fs::path(staging_) / "manifest.json");
+    out << manifest.dump(2) << "\n";
+    if (!out) {
+      throw std::runtime_error("Cannot write archive manifest in " + staging_);
+    }
+  }
+
+  // A crash between the two steps loses the old copy, and the window is
+  // fetched again on the next run
+  fs::remove_all(window_.path);
+  fs::rename(staging_, window_.path);
+  committed_ = true;
+}
@@ -0,0 +1,274 @@
+/**
+ * @file ArchiveLoader.cpp
+ * @brief Parallel bulk load of the raw page archive implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/ArchiveLoader.h"
+#include "config/Config.h"
+#include "db/RecordTable.h"
+#include "oai/OaiClient.h"
+#include "utils/Logger.h"
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <libxml/parser.h>
+#include <map>
+#include <thread>
+
+namespace {
+
+// Rows per COPY stream: large enough to amortize the round trip, small
+// enough that the copy connections start while parsing is still going
+constexpr long kStreamRows = 20000;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+ArchiveLoader::ArchiveLoader(Database &db, const Repository &repository,
+                             HarvestLog &harvest_log, ColumnProfile profile,
+                             PartitionScheme scheme)
+    : db_(db), repository_(repository), harvest_log_(harvest_log),
+      profile_(profile), scheme_(scheme), next_page_(0) {
+  Config &config = Config::instance();
+  setParsers(config.getLoadParsers());
+  setConnections(config.getLoadConnections());
+}
+
+void ArchiveLoader::setParsers(int parsers) {
+  // 0 means one per core
+  parsers_ = parsers > 0
+                 ? parsers
+                 : std::max(1, static_cast<int>(
+                                   std::thread::hardware_concurrency()));
+}
+
+void ArchiveLoader::setConnections(int connections) {
+  connections_ = std::max(1, connections);
+}
+
+long ArchiveLoader::run(const std::string &archive_dir,
+                        const std::vector<std::string> &set_specs) {
+  stages_.clear();
+  Config &config = Config::instance();
+
+  // Scan: pick the windows to load and flatten their pages into one list
+  auto scan_started = std::chrono::steady_clock::now();
+  LoadStage scanned{"scan"};
+  std::vector<WindowLoad> windows;
+  int current = 0;
+
+  for (auto &archived : PageArchive(archive_dir).list(repository_.name)) {
+    if (!archived.set_spec.empty() &&
+        std::find(set_specs.begin(), set_specs.end(), archived.set_spec) ==
+            set_specs.end()) {
+      continue;
+    }
+
+    WindowLoad window;
+    if (archived.set_spec.empty()) {
+      window.route_sets = set_specs;
+    }
+    const std::vector<std::string> lane_sets =
+        archived.set_spec.empty() ? set_specs
+                                  : std::vector<std::string>{archived.set_spec};
+    bool covered = true;
+    for (const auto &set_spec : lane_sets) {
+      covered = covered && harvest_log_.coveredSince(
+                               set_spec, archived.from_date,
+                               archived.until_date, archived.fetched_at);
+    }
+    if (covered) {
+      current++;
+      continue;
+    }
+
+    window.files = archived.pageFiles();
+    window.ledger.set_spec = archived.set_spec;
+    window.ledger.from_date = archived.from_date;
+    window.ledger.until_date = archived.until_date;
+    window.ledger.pages = archived.pages;
+    window.ledger.complete_list_size = archived.complete_list_size;
+    scanned.records += archived.records;
+    window.archived = std::move(archived);
+    windows.push_back(std::move(window));
+  }
+
+  std::vector<PageRef> pages;
+  for (size_t w = 0; w < windows.size(); ++w) {
+    for (size_t p = 0; p < windows[w].files.size(); ++p) {
+      pages.push_back({w, p});
+    }
+  }
+  scanned.seconds = secondsSince(scan_started);
+  stages_.push_back(scanned);
+
+  spdlog::info("Loading {} archived windows ({} pages, {} records) of {} "
+               "with {} parsers and {} COPY connections; {} windows already "
+               "current",
+               windows.size(), pages.size(), scanned.records,
+               repository_.name, parsers_, connections_, current);
+  if (pages.empty()) {
+    return 0;
+  }
+
+  // Parse and copy run side by side; the bounded stream queue between them
+  // holds back the parsers when the connections fall behind
+  BulkLoader bulk(config.getPostgresSchema(), repository_.table, scheme_,
+                  connections_);
+  bulk.start();
+
+  // libxml2 sets up its global state once, before the parser threads;
+  // main() already did, and the call is a no-op then
+  xmlInitParser();
+  auto parse_started = std::chrono::steady_clock::now();
+  next_page_ = 0;
+  std::vector<LoadStage> parsed(static_cast<size_t>(parsers_));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < parsers_; ++i) {
+    threads.emplace_back([&, i] {
+      parseWorker(windows, pages, bulk, parsed[static_cast<size_t>(i)]);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  LoadStage parse{"parse"};
+  for (const auto &stage : parsed) {
+    parse.records += stage.records;
+    parse.bytes += stage.bytes;
+  }
+  parse.seconds = secondsSince(parse_started);
+  stages_.push_back(parse);
+
+  // Only windows parsed in full are logged as complete; their rows and
+  // ledger entries commit together
+  bulk.finish(db_, [&] { recordLedger(windows); });
+
+  stages_.push_back(
+      {"copy", bulk.copiedRows(), bulk.copiedBytes(), bulk.copySeconds()});
+  stages_.push_back({"merge", bulk.copiedRows(), 0, bulk.mergeSeconds()});
+
+  int loaded = 0;
+  int failed = 0;
+  long dropped = 0;
+  for (const auto &window : windows) {
+    if (window.failed) {
+      failed++;
+    } else if (window.pages_parsed == window.files.size()) {
+      loaded++;
+    }
+    dropped += window.dropped;
+  }
+
+  spdlog::info("Archive load completed: {} windows loaded ({} records), {} "
+               "failed, {} left for the next run",
+               loaded, bulk.copiedRows(), failed,
+               windows.size() - static_cast<size_t>(loaded + failed));
+  if (dropped > 0) {
+    spdlog::info("Skipped {} records outside the configured sets", dropped);
+  }
+  BulkLoader::logStages(stages_);
+  return bulk.copiedRows();
+}
+
+void ArchiveLoader::parseWorker(std::vector<WindowLoad> &windows,
+                                const std::vector<PageRef> &pages,
+                                BulkLoader &bulk, LoadStage &parsed) {
+  CopyEncoder encoder;
+  auto submit = [&] {
+    long rows = static_cast<long>(encoder.rows());
+    encoder.finish();
+    bulk.submit(encoder.take(), rows);
+  };
+
+  for (size_t i = next_page_++; i < pages.size() && !interrupted();
+       i = next_page_++) {
+    WindowLoad &window = windows[pages[i].window];
+    std::map<std::string, int> day_counts;
+    std::map<std::string, std::map<std::string, int>> set_day_counts;
+    long dropped = 0;
+    size_t page_records = 0;
+
+    try {
+      MappedFile file(window.files[pages[i].page]);
+      OaiPage page = OaiClient::parseXmlResponse(file.view());
+      parsed.bytes += static_cast<long>(file.size());
+      page_records = page.records.size();
+
+      for (const auto &record : page.records) {
+        std::string day = record.header_datestamp.substr(0, 10);
+        bool keep = window.route_sets.empty();
+        for (const auto &set_spec : window.route_sets) {
+          if (record.inSet(set_spec)) {
+            set_day_counts[set_spec][day]++;
+            keep = true;
+          }
+        }
+        if (!keep) {
+          dropped++;
+          continue;
+        }
+        day_counts[day]++;
+        RecordTable::encode(encoder, record, profile_);
+        parsed.records++;
+        if (static_cast<long>(encoder.rows()) >= kStreamRows) {
+          submit();
+        }
+      }
+    } catch (const std::exception &e) {
+      spdlog::error("Error parsing {}: {}", window.files[pages[i].page],
+                    e.what());
+      std::lock_guard<std::mutex> lock(mutex_);
+      window.failed = true;
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &[day, count] : day_counts) {
+      window.ledger.day_counts[day] += count;
+    }
+    for (const auto &[set_spec, counts] : set_day_counts) {
+      for (const auto &[day, count] : counts) {
+        window.ledger.set_day_counts[set_spec][day] += count;
+      }
+    }
+    if (pages[i].page == 0 && window.files.size() > 1) {
+      window.ledger.page_size = static_cast<int>(page_records);
+    }
+    window.dropped += dropped;
+    window.pages_parsed++;
+  }
+
+  if (encoder.rows() > 0) {
+    submit();
+  }
+}
+
+void ArchiveLoader::recordLedger(const std::vector<WindowLoad> &windows) {
+  for (const auto &window : windows) {
+    if (window.failed || window.pages_parsed != window.files.size()) {
+      continue;
+    }
+    if (window.route_sets.empty()) {
+      harvest_log_.recordComplete(window.ledger);
+      continue;
+    }
+    for (const auto &set_spec : window.route_sets) {
+      HarvestWindow set_window = window.ledger;
+      set_window.set_spec = set_spec;
+      auto counts = window.ledger.set_day_counts.find(set_spec);
+      set_window.day_counts = counts == window.ledger.set_day_counts.end()
+                                  ? std::map<std::string, int>{}
+                                  : counts->second;
+      set_window.set_day_counts.clear();
+      harvest_log_.recordComplete(set_window);
+    }
+  }
+}
@@ -0,0 +1,340 @@
+/**
+ * @file BackfillPlanner.cpp
+ * @brief Turns missing days into harvest windows for backfill implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/BackfillPlanner.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Known counts within this many days either side inform an estimate
+constexpr long kNeighbourhoodDays = 30;
+
+// Typical oai_dc record on the wire (abstract included) and the per-response
+// envelope and resumptionToken; used only for dry-run projections
+constexpr long kBytesPerRecord = 2500;
+constexpr long kBytesPerResponse = 1024;
+
+// Server time per ListRecords page on top of the rate-limit delay
+constexpr long kSecondsPerResponse = 2;
+
+json rangeToJson(const DateRange &range) {
+  return {{"from", range.from_date},
+          {"until", range.until_date},
+          {"days", range.days}};
+}
+
+} // namespace
+
+BackfillPlanner::BackfillPlanner(int page_size, int target_pages)
+    : page_size_(std::max(page_size, 1)),
+      target_pages_(std::max(target_pages, 1)), unknown_scale_(1.0) {}
+
+long BackfillPlanner::toDayNumber(const std::string &date) {
+  int year, month, day;
+  if (std::sscanf(date.c_str(), "%4d-%2d-%2d", &year, &month, &day) != 3) {
+    throw std::invalid_argument("Invalid date: " + date);
+  }
+
+  std::chrono::year_month_day ymd{std::chrono::year{year},
+                                  std::chrono::month{static_cast<unsigned>(month)},
+                                  std::chrono::day{static_cast<unsigned>(day)}};
+  if (!ymd.ok()) {
+    throw std::invalid_argument("Invalid date: " + date);
+  }
+  return std::chrono::sys_days{ymd}.time_since_epoch().count();
+}
+
+std::string BackfillPlanner::fromDayNumber(long day_number) {
+  std::chrono::year_month_day ymd{
+      std::chrono::sys_days{std::chrono::days{day_number}}};
+
+  char date_str[40];
+  std::snprintf(date_str, sizeof(date_str), "%04d-%02u-%02u",
+                static_cast<int>(ymd.year()),
+                static_cast<unsigned>(ymd.month()),
+                static_cast<unsigned>(ymd.day()));
+  return date_str;
+}
+
+std::pair<std::string, std::string>
+BackfillPlanner::resolveRange(const std::string &start_date,
+                              const std::string &end_date) {
+  std::string start = start_date.empty() ? "2007-01-01" : start_date;
+  
+  // Use current date as default end date instead of hardcoded 2026-01-01
+  std::string end;
+  if (end_date.empty()) {
+    auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::tm *tm_ptr = std::localtime(&time_t);
+    // Set to yesterday to avoid potential issues with current day
+    tm_ptr->tm_mday -= 1;
+    mktime(tm_ptr); // Normalize
+    char date_str[11];
+    strftime(date_str, sizeof(date_str), "%Y-%m-%d", tm_ptr);
+    end = date_str;
+  } else {
+    end = end_date;
+  }
+  return {start, end};
+}
+
+std::vector<DateRange> BackfillPlanner::monthlyWindows(const std::string &start,
+                                                       const std::string &end) {
+  std::vector<DateRange> windows;
+  long first = toDayNumber(start);
+  long last = toDayNumber(end);
+
+  while (first <= last) {
+    std::chrono::year_month_day ymd{
+        std::chrono::sys_days{std::chrono::days{first}}};
+    long month_end =
+        std::chrono::sys_days{ymd.year() / ymd.month() / std::chrono::last}
+            .time_since_epoch()
+            .count();
+    long until = std::min(month_end, last);
+    windows.push_back({fromDayNumber(first), fromDayNumber(until),
+                       static_cast<int>(until - first + 1)});
+    first = until + 1;
+  }
+  return windows;
+}
+
+std::vector<DateRange>
+BackfillPlanner::coalesce(const std::vector<std::string> &days) {
+  std::vector<DateRange> ranges;
+
+  long run_start = 0;
+  long run_end = 0;
+  for (const auto &day : days) {
+    long current = toDayNumber(day);
+    if (!ranges.empty() && current == run_end + 1) {
+      run_end = current;
+      ranges.back().until_date = day;
+      ranges.back().days = static_cast<int>(run_end - run_start + 1);
+      continue;
+    }
+
+    run_start = run_end = current;
+    ranges.push_back({day, day, 1});
+  }
+
+  return ranges;
+}
+
+void BackfillPlanner::addDayCount(const std::string &day, long count) {
+  known_counts_[toDayNumber(day)] = count;
+}
+
+void BackfillPlanner::observePageSize(int page_size) {
+  if (page_size > 0 && page_size != page_size_) {
+    spdlog::debug("Planner page size {} -> {}", page_size_, page_size);
+    page_size_ = page_size;
+  }
+}
+
+void BackfillPlanner::observeWindow(const DateRange &window,
+                                    long complete_list_size) {
+  if (complete_list_size < 0 || window.estimated_records <= 0) {
+    return;
+  }
+
+  // Move the correction for days without history towards what the server
+  // reported, damped so that one unusual window does not swing the plan
+  double ratio = static_cast<double>(complete_list_size) /
+                 static_cast<double>(window.estimated_records);
+  ratio = std::clamp(ratio, 0.1, 10.0);
+  unknown_scale_ = std::clamp(unknown_scale_ * (0.5 + 0.5 * ratio), 0.01, 100.0);
+}
+
+double BackfillPlanner::estimateDay(long day_number) const {
+  auto exact = known_counts_.find(day_number);
+  if (exact != known_counts_.end()) {
+    return static_cast<double>(exact->second);
+  }
+
+  double sum = 0;
+  long samples = 0;
+  for (auto it = known_counts_.lower_bound(day_number - kNeighbourhoodDays);
+       it != known_counts_.end() && it->first <= day_number + kNeighbourhoodDays;
+       ++it) {
+    sum += static_cast<double>(it->second);
+    samples++;
+  }
+
+  if (samples == 0) {
+    for (const auto &[day, count] : known_counts_) {
+      sum += static_cast<double>(count);
+      samples++;
+    }
+  }
+
+  // Without any history, assume about one page per week of data, which is
+  // what the old fixed 7-day chunk was tuned for
+  double base = samples > 0 ? sum / static_cast<double>(samples)
+                            : static_cast<double>(page_size_) / 7.0;
+  return base * unknown_scale_;
+}
+
+long BackfillPlanner::pagesFor(double records) const {
+  return std::max(1L, static_cast<long>(std::ceil(records / page_size_)));
+}
+
+DateRange
+BackfillPlanner::nextWindow(const std::vector<std::string> &missing_days,
+                            size_t &next) const {
+  const double capacity = static_cast<double>(page_size_) * target_pages_;
+
+  long first = toDayNumber(missing_days[next]);
+  long last = first;
+  double records = estimateDay(first);
+  next++;
+
+  while (next < missing_days.size()) {
+    long candidate = toDayNumber(missing_days[next]);
+
+    if (candidate == last + 1) {
+      // Adjacent day: extend while the window stays within its page budget
+      double day_records = estimateDay(candidate);
+      if (records + day_records > capacity) {
+        break;
+      }
+      records += day_records;
+    } else {
+      // Records on the already-covered days that a bridged window re-fetches
+      double gap = 0;
+      for (long day = last + 1; day < candidate; ++day) {
+        gap += estimateDay(day);
+      }
+
+      // The contiguous missing run that starts at the candidate. Only
+      // bridges look ahead, so each run is walked here once and then once
+      // more day by day as the window extends into it.
+      double run = 0;
+      size_t run_end = next;
+      for (long expected = candidate;
+           run_end < missing_days.size() &&
+           toDayNumber(missing_days[run_end]) == expected;
+           ++expected, ++run_end) {
+        run += estimateDay(expected);
+        if (records + gap + run >= capacity) {
+          break;
+        }
+      }
+
+      // Bridge only when one stream over the gap needs fewer requests than
+      // finishing this window and starting the next one
+      double merged = records + gap + run;
+      if (merged > capacity ||
+          pagesFor(merged) >= pagesFor(records) + pagesFor(run)) {
+        break;
+      }
+      records += gap + estimateDay(candidate);
+    }
+
+    last = candidate;
+    next++;
+  }
+
+  DateRange window{fromDayNumber(first), fromDayNumber(last),
+                   static_cast<int>(last - first + 1)};
+  window.estimated_records = static_cast<long>(std::llround(records));
+  return window;
+}
+
+long BackfillPlan::bytesFor(const LanePlan &lane) const {
+  return lane.estimated_records * kBytesPerRecord +
+         lane.requests * kBytesPerResponse;
+}
+
+long BackfillPlan::secondsFor(const LanePlan &lane) const {
+  return lane.requests * (rate_limit_delay + kSecondsPerResponse);
+}
+
+std::string BackfillPlan::toJson() const {
+  json lanes_json = json::array();
+  long total_days = 0, total_records = 0, total_requests = 0;
+  long total_bytes = 0, total_seconds = 0;
+
+  for (const auto &lane : lanes) {
+    json gaps = json::array();
+    for (const auto &gap : lane.gaps) {
+      gaps.push_back(rangeToJson(gap));
+    }
+
+    json windows = json::array();
+    for (size_t i = 0; i < lane.windows.size(); ++i) {
+      json window = rangeToJson(lane.windows[i]);
+      window["estimated_records"] = lane.windows[i].estimated_records;
+      window["estimated_pages"] = lane.window_pages[i];
+      windows.push_back(std::move(window));
+    }
+
+    lanes_json.push_back({{"set_spec", lane.set_spec},
+                          {"missing_days", lane.missing_days},
+                          {"gaps", std::move(gaps)},
+                          {"windows", std::move(windows)},
+                          {"estimated_records", lane.estimated_records},
+                          {"requests", lane.requests},
+                          {"bytes", bytesFor(lane)},
+                          {"eta_seconds", secondsFor(lane)}});
+
+    total_days += lane.missing_days;
+    total_records += lane.estimated_records;
+    total_requests += lane.requests;
+    total_bytes += bytesFor(lane);
+    total_seconds += secondsFor(lane);
+  }
+
+  json plan = {
+      {"start_date", start_date},
+      {"end_date", end_date},
+      {"assumptions",
+       {{"page_size", page_size},
+        {"rate_limit_delay", rate_limit_delay},
+        {"bytes_per_record", kBytesPerRecord},
+        {"bytes_per_response", kBytesPerResponse},
+        {"seconds_per_response", kSecondsPerResponse}}},
+      {"sets", std::move(lanes_json)},
+      {"totals",
+       {{"missing_days", total_days},
+        {"estimated_records", total_records},
+        {"requests", total_requests},
+        {"bytes", total_bytes},
+        {"eta_seconds", total_seconds}}}};
+  return plan.dump(2);
+}
+
+void BackfillPlan::log() const {
+  spdlog::info("Backfill plan from {} to {} (page size {}, {} s between "
+               "requests)",
+               start_date, end_date, page_size, rate_limit_delay);
+
+  long total_requests = 0, total_bytes = 0, total_seconds = 0;
+  for (const auto &lane : lanes) {
+    spdlog::info("  {:<12} {:>6} missing days in {:>4} gaps -> {:>4} windows, "
+                 "~{} records, {} requests, ~{:.1f} MB, ~{:.1f} h",
+                 lane.set_spec.empty() ? "all sets" : lane.set_spec,
+                 lane.missing_days, lane.gaps.size(), lane.windows.size(),
+                 lane.estimated_records, lane.requests,
+                 bytesFor(lane) / 1e6, secondsFor(lane) / 3600.0);
+    total_requests += lane.requests;
+    total_bytes += bytesFor(lane);
+    total_seconds += secondsFor(lane);
+  }
+
+  spdlog::info("Total: {} requests, ~{:.1f} MB, ~{:.1f} h", total_requests,
+               total_bytes / 1e6, total_seconds / 3600.0);
+}
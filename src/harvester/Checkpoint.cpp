@@ -0,0 +1,196 @@
+/**
+ * @file Checkpoint.cpp
+ * @brief Durable per-lane harvest checkpoints for crash-safe resume implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/Checkpoint.h"
+#include "utils/Logger.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+json countsToJson(const HarvestWindow &window) {
+  json counts = json::object();
+  counts[""] = window.day_counts;
+  for (const auto &[set_spec, days] : window.set_day_counts) {
+    counts[set_spec] = days;
+  }
+  return counts;
+}
+
+void countsFromJson(const json &counts, HarvestWindow &window) {
+  for (const auto &[key, days] : counts.items()) {
+    auto &target = key.empty() ? window.day_counts : window.set_day_counts[key];
+    for (const auto &[day, count] : days.items()) {
+      target[day] = count.get<int>();
+    }
+  }
+}
+
+json toJson(const Checkpoint &checkpoint) {
+  return {{"lane", checkpoint.lane},
+          {"set_spec", checkpoint.window.set_spec},
+          {"from_date", checkpoint.window.from_date},
+          {"until_date", checkpoint.window.until_date},
+          {"pages", checkpoint.window.pages},
+          {"page_size", checkpoint.window.page_size},
+          {"complete_list_size", checkpoint.window.complete_list_size},
+          {"resumption_token", checkpoint.resumption_token},
+          {"token_expiration", checkpoint.token_expiration},
+          {"day_counts", countsToJson(checkpoint.window)}};
+}
+
+Checkpoint fromJson(const json &j) {
+  Checkpoint checkpoint;
+  checkpoint.lane = j.value("lane", "");
+  checkpoint.window.set_spec = j.value("set_spec", "");
+  checkpoint.window.from_date = j.value("from_date", "");
+  checkpoint.window.until_date = j.value("until_date", "");
+  checkpoint.window.pages = j.value("pages", 0);
+  checkpoint.window.page_size = j.value("page_size", 0);
+  checkpoint.window.complete_list_size = j.value("complete_list_size", -1L);
+  checkpoint.resumption_token = j.value("resumption_token", "");
+  checkpoint.token_expiration = j.value("token_expiration", "");
+  if (j.contains("day_counts")) {
+    countsFromJson(j["day_counts"], checkpoint.window);
+  }
+  return checkpoint;
+}
+
+} // namespace
+
+bool Checkpoint::tokenExpired() const {
+  if (token_expiration.empty()) {
+    return false;
+  }
+
+  // ISO 8601 UTC timestamps of equal shape compare lexicographically
+  std::time_t now = std::time(nullptr);
+  char now_str[21];
+  std::strftime(now_str, sizeof(now_str), "%Y-%m-%dT%H:%M:%SZ",
+                std::gmtime(&now));
+  return token_expiration.substr(0, 19) <= std::string(now_str, 19);
+}
+
+std::string Checkpoint::laneFor(const std::string &set_spec) {
+  return set_spec.empty() ? "*" : set_spec;
+}
+
+std::unique_ptr<CheckpointStore>
+CheckpointStore::create(Database &db, const std::string &schema_name,
+                        const std::string &file_path,
+                        const std::string &prefix) {
+  if (!file_path.empty()) {
+    // dir/checkpoints.json -> dir/<prefix>checkpoints.json
+    std::string path = file_path;
+    size_t slash = path.find_last_of('/');
+    path.insert(slash == std::string::npos ? 0 : slash + 1, prefix);
+    spdlog::info("Checkpoints stored in {}", path);
+    return std::make_unique<FileCheckpointStore>(path);
+  }
+  return std::make_unique<PostgresCheckpointStore>(db, schema_name, prefix);
+}
+
+PostgresCheckpointStore::PostgresCheckpointStore(Database &db,
+                                                 const std::string &schema_name,
+                                                 const std::string &prefix)
+    : db_(db), table_(schema_name + "." + prefix + "harvest_checkpoint") {
+  db_.execute("CREATE TABLE IF NOT EXISTS " + table_ +
+              " ("
+              "lane VARCHAR(100) PRIMARY KEY, "
+              "state JSONB NOT NULL, "
+              "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+              ")");
+}
+
+std::optional<Checkpoint>
+PostgresCheckpointStore::load(const std::string &lane) {
+  PGresult *res = db_.query("SELECT state FROM " + table_ + " WHERE lane = $1",
+                            {lane.c_str()});
+  std::optional<Checkpoint> checkpoint;
+  if (PQntuples(res) > 0) {
+    json state = json::parse(PQgetvalue(res, 0, 0), nullptr, false);
+    if (!state.is_discarded()) {
+      checkpoint = fromJson(state);
+    }
+  }
+  PQclear(res);
+  return checkpoint;
+}
+
+void PostgresCheckpointStore::save(const Checkpoint &checkpoint) {
+  std::string state = toJson(checkpoint).dump();
+  db_.execute("INSERT INTO " + table_ +
+                  " (lane, state, updated_at) VALUES ($1, $2, "
+                  "CURRENT_TIMESTAMP) "
+                  "ON CONFLICT (lane) DO UPDATE SET state = EXCLUDED.state, "
+                  "updated_at = EXCLUDED.updated_at",
+              {checkpoint.lane.c_str(), state.c_str()});
+}
+
+void PostgresCheckpointStore::clear(const std::string &lane) {
+  db_.execute("DELETE FROM " + table_ + " WHERE lane = $1", {lane.c_str()});
+}
+
+FileCheckpointStore::FileCheckpointStore(const std::string &file_path)
+    : file_path_(file_path) {}
+
+std::string FileCheckpointStore::readAll() {
+  std::ifstream file(file_path_);
+  if (!file.is_open()) {
+    return "";
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+void FileCheckpointStore::writeAll(const std::string &contents) {
+  const std::string temp_path = file_path_ + ".tmp";
+
+  FILE *file = std::fopen(temp_path.c_str(), "w");
+  if (!file) {
+    throw std::runtime_error("Cannot write checkpoint file " + temp_path);
+  }
+  bool ok = std::fwrite(contents.data(), 1, contents.size(), file) ==
+                contents.size() &&
+            std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok || std::rename(temp_path.c_str(), file_path_.c_str()) != 0) {
+    throw std::runtime_error("Cannot write checkpoint file " + file_path_);
+  }
+}
+
+std::optional<Checkpoint> FileCheckpointStore::load(const std::string &lane) {
+  json all = json::parse(readAll(), nullptr, false);
+  if (all.is_discarded() || !all.contains(lane)) {
+    return std::nullopt;
+  }
+  return fromJson(all[lane]);
+}
+
+void FileCheckpointStore::save(const Checkpoint &checkpoint) {
+  json all = json::parse(readAll(), nullptr, false);
+  if (all.is_discarded() || !all.is_object()) {
+    all = json::object();
+  }
+  all[checkpoint.lane] = toJson(checkpoint);
+  writeAll(all.dump(2));
+}
+
+void FileCheckpointStore::clear(const std::string &lane) {
+  json all = json::parse(readAll(), nullptr, false);
+  if (all.is_discarded() || !all.contains(lane)) {
+    return;
+  }
+  all.erase(lane);
+  writeAll(all.dump(2));
+}
@@ -0,0 +1,133 @@
+/**
+ * @file Daemon.cpp
+ * @brief Long-running harvest loop with an internal daily schedule implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/Daemon.h"
+#include "config/Config.h"
+#include "utils/Logger.h"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+
+void handleStopSignal(int) { stop_requested = true; }
+
+std::string formatUtc(Daemon::Clock::time_point when) {
+  std::time_t t = Daemon::Clock::to_time_t(when);
+  char buffer[21];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%SZ", std::gmtime(&t));
+  return buffer;
+}
+
+} // namespace
+
+Daemon::Daemon(Database &db, Harvester &harvester,
+               const std::vector<std::string> &set_specs)
+    : db_(db), harvester_(harvester), set_specs_(set_specs) {
+  Config &config = Config::instance();
+  recent_minute_ = parseTimeOfDay(config.getDaemonRecentTime());
+  retry_delay_ = config.getDaemonRetryDelay();
+}
+
+void Daemon::setBackfillRange(const std::string &start_date,
+                              const std::string &end_date) {
+  backfill_start_ = start_date;
+  backfill_end_ = end_date;
+}
+
+void Daemon::installSignalHandlers() {
+  std::signal(SIGTERM, handleStopSignal);
+  std::signal(SIGINT, handleStopSignal);
+}
+
+bool Daemon::stopRequested() { return stop_requested; }
+
+int Daemon::parseTimeOfDay(const std::string &value) {
+  int hours = 0;
+  int minutes = 0;
+  if (std::sscanf(value.c_str(), "%d:%d", &hours, &minutes) != 2 ||
+      hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+    throw std::runtime_error("Invalid DAEMON_RECENT_TIME: " + value +
+                             " (expected HH:MM in UTC)");
+  }
+  return hours * 60 + minutes;
+}
+
+Daemon::Clock::time_point Daemon::nextRecentSlot(Clock::time_point after) const {
+  std::time_t t = Clock::to_time_t(after);
+  std::tm day = *std::gmtime(&t);
+  day.tm_hour = recent_minute_ / 60;
+  day.tm_min = recent_minute_ % 60;
+  day.tm_sec = 0;
+
+  auto slot = Clock::from_time_t(timegm(&day));
+  if (slot <= after) {
+    slot += std::chrono::hours(24);
+  }
+  return slot;
+}
+
+bool Daemon::sleepUntil(Clock::time_point deadline) const {
+  while (!stopRequested() && Clock::now() < deadline) {
+    auto step = std::min<Clock::duration>(deadline - Clock::now(),
+                                          std::chrono::seconds(1));
+    std::this_thread::sleep_for(step);
+  }
+  return !stopRequested();
+}
+
+int Daemon::run() {
+  int total_records = 0;
+
+  // Catch up immediately on start, then follow the daily slot
+  Clock::time_point next_recent = Clock::now();
+  bool backfill_pending = true;
+
+  spdlog::info("Daemon started; incremental harvests daily at {:02d}:{:02d} UTC",
+               recent_minute_ / 60, recent_minute_ % 60);
+
+  while (!stopRequested()) {
+    try {
+      db_.ensureConnected();
+
+      if (Clock::now() >= next_recent) {
+        harvester_.setInterrupt(&Daemon::stopRequested);
+        total_records += harvester_.harvestIncremental(set_specs_);
+        next_recent = nextRecentSlot(Clock::now());
+        // A new announcement day can open new gaps
+        backfill_pending = true;
+        spdlog::info("Next incremental harvest at {}", formatUtc(next_recent));
+
+      } else if (backfill_pending) {
+        // Backfill only uses the budget until the next recent slot; an
+        // interrupted window keeps its checkpoint and resumes afterwards
+        harvester_.setInterrupt([next_recent] {
+          return stopRequested() || Clock::now() >= next_recent;
+        });
+        total_records += harvester_.harvestBackfill(
+            backfill_start_, backfill_end_, set_specs_);
+        backfill_pending = false;
+
+      } else {
+        spdlog::info("Idle until {}", formatUtc(next_recent));
+        sleepUntil(next_recent);
+      }
+
+    } catch (const std::exception &e) {
+      spdlog::error("Daemon cycle failed: {}; retrying in {} seconds",
+                    e.what(), retry_delay_);
+      sleepUntil(Clock::now() + std::chrono::seconds(retry_delay_));
+    }
+  }
+
+  harvester_.setInterrupt(nullptr);
+  spdlog::info("Daemon stopping after {} records", total_records);
+  return total_records;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file MultiHarvester.cpp
+ * @brief Concurrent harvesting of several OAI-PMH repositories implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/MultiHarvester.h"
+#include "db/Database.h"
+#include "utils/Logger.h"
+#include <thread>
+
+MultiHarvester::MultiHarvester(std::vector<Repository> repositories)
+    : repositories_(std::move(repositories)), failures_(0) {}
+
+int MultiHarvester::run(const Job &job) {
+  return runEach([&](const Repository &repository) {
+    // libpq connections must not be shared between threads
+    Database db;
+    db.connect();
+    Harvester harvester(db, repository);
+    int records = job(harvester, repository);
+    db.disconnect();
+    return records;
+  });
+}
+
+int MultiHarvester::runEach(const RepositoryJob &job) {
+  std::vector<int> totals(repositories_.size(), 0);
+  std::vector<char> failed(repositories_.size(), 0);
+  std::vector<std::thread> workers;
+
+  for (size_t i = 0; i < repositories_.size(); ++i) {
+    workers.emplace_back([&, i] {
+      const Repository &repository = repositories_[i];
+      try {
+        totals[i] = job(repository);
+      } catch (const std::exception &e) {
+        spdlog::error("Repository {} failed: {}", repository.name, e.what());
+        failed[i] = 1;
+      }
+    });
+  }
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  int total_records = 0;
+  failures_ = 0;
+  spdlog::info("Repository summary:");
+  for (size_t i = 0; i < repositories_.size(); ++i) {
+    spdlog::info("  {} ({}): {} records{}", repositories_[i].name,
+                 repositories_[i].host(), totals[i],
+                 failed[i] ? ", FAILED" : "");
+    total_records += totals[i];
+    failures_ += failed[i] ? 1 : 0;
+  }
+  return total_records;
+}
@@ -6,35 +6,69 @@
 
 #include "harvester/RateLimiter.h"
 #include "utils/Logger.h"
+#include <algorithm>
+#include <map>
 
 RateLimiter::RateLimiter(int delay_seconds) : delay_ms_(delay_seconds * 1000) {}
 
-void RateLimiter::wait_before_request() {
-  auto now = std::chrono::steady_clock::now();
+std::shared_ptr<RateLimiter> RateLimiter::forHost(const std::string &host,
+                                                  int delay_seconds) {
+  static std::mutex registry_mutex;
+  static std::map<std::string, std::shared_ptr<RateLimiter>> limiters;
 
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto &limiter = limiters[host];
+  if (!limiter) {
+    limiter = std::make_shared<RateLimiter>(delay_seconds);
+  } else {
+    std::lock_guard<std::mutex> limiter_lock(limiter->mutex_);
+    limiter->delay_ms_ = std::max(limiter->delay_ms_, delay_seconds * 1000);
+  }
+  return limiter;
+}
+
+std::chrono::steady_clock::time_point RateLimiter::reserve() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = std::chrono::steady_clock::now();
+  auto slot = now;
   if (last_request_.time_since_epoch().count() > 0) {
-    auto elapsed = now - last_request_;
-    auto elapsed_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
-
-    if (elapsed_ms < delay_ms_) {
-      auto remaining = delay_ms_ - elapsed_ms;
-      spdlog::debug("Rate limiting: waiting {} ms before request", remaining);
-      std::this_thread::sleep_for(std::chrono::milliseconds(remaining));
-    }
+    slot = std::max(now, last_request_ + std::chrono::milliseconds(delay_ms_));
   }
+  last_request_ = slot;
+  return slot;
+}
 
-  last_request_ = std::chrono::steady_clock::now();
+void RateLimiter::defer(std::chrono::steady_clock::time_point until) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto last = until - std::chrono::milliseconds(delay_ms_);
+  if (last > last_request_) {
+    last_request_ = last;
+  }
+}
+
+void RateLimiter::wait_before_request() {
+  // Reserve the next free slot under the lock, then sleep outside it
+  auto slot = reserve();
+  auto remaining = slot - std::chrono::steady_clock::now();
+  if (remaining > std::chrono::steady_clock::duration::zero()) {
+    spdlog::debug("Rate limiting: waiting {} ms before request",
+                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                      remaining)
+                      .count());
+    std::this_thread::sleep_for(remaining);
+  }
 }
 
 void RateLimiter::wait_between_batches() {
   spdlog::debug("Rate limiting: waiting {} ms between batches", delay_ms_);
   std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+  std::lock_guard<std::mutex> lock(mutex_);
   last_request_ = std::chrono::steady_clock::now();
 }
 
 void RateLimiter::wait_between_set_specs() {
   spdlog::debug("Rate limiting: waiting {} ms between set_specs", delay_ms_);
   std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+  std::lock_guard<std::mutex> lock(mutex_);
   last_request_ = std::chrono::steady_clock::now();
 }
@@ -0,0 +1,89 @@
+/**
+ * @file Repository.cpp
+ * @brief OAI-PMH repository registry entries implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/Repository.h"
+#include "config/Config.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+std::string Repository::host() const {
+  size_t start = base_url.find("://");
+  start = start == std::string::npos ? 0 : start + 3;
+  size_t end = base_url.find_first_of("/?#", start);
+  return base_url.substr(start, end == std::string::npos ? std::string::npos
+                                                         : end - start);
+}
+
+Repository Repository::fromConfig(const std::vector<std::string> &set_specs) {
+  Config &config = Config::instance();
+
+  Repository repository;
+  repository.name = "arxiv";
+  repository.base_url = config.getArxivBaseUrl();
+  repository.set_specs = set_specs;
+  repository.rate_limit_delay = config.getRateLimitDelay();
+  repository.max_retries = config.getMaxRetries();
+  repository.max_inflight = config.getMaxInflight();
+  repository.table = config.getPostgresTable();
+  return repository;
+}
+
+std::vector<Repository> Repository::loadRegistry(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("Cannot open repository registry " + path);
+  }
+
+  json entries = json::parse(file, nullptr, false);
+  if (entries.is_discarded() || !entries.is_array()) {
+    throw std::runtime_error("Repository registry " + path +
+                             " must be a JSON array");
+  }
+
+  Config &config = Config::instance();
+  std::vector<Repository> repositories;
+  std::set<std::string> tables;
+
+  for (const auto &entry : entries) {
+    Repository repository;
+    repository.name = entry.value("name", "");
+    repository.base_url = entry.value("base_url", "");
+    if (repository.name.empty() || repository.base_url.empty()) {
+      throw std::runtime_error("Registry entries need a name and a base_url");
+    }
+
+    repository.metadata_prefix = entry.value("metadata_prefix", "oai_dc");
+    repository.set_specs =
+        entry.value("set_specs", std::vector<std::string>{});
+    if (repository.set_specs.empty()) {
+      throw std::runtime_error("Repository " + repository.name +
+                               " lists no set_specs");
+    }
+    repository.rate_limit_delay =
+        entry.value("rate_limit_delay", config.getRateLimitDelay());
+    repository.max_retries = entry.value("max_retries", config.getMaxRetries());
+    repository.max_inflight =
+        std::max(1, entry.value("max_inflight", config.getMaxInflight()));
+    repository.table = entry.value("table", repository.name);
+    repository.ledger_prefix =
+        entry.value("ledger_prefix", repository.name + "_");
+
+    if (!tables.insert(repository.table).second) {
+      throw std::runtime_error("Two repositories target table " +
+                               repository.table);
+    }
+    repositories.push_back(std::move(repository));
+  }
+
+  spdlog::info("Loaded {} repositories from {}", repositories.size(), path);
+  return repositories;
+}
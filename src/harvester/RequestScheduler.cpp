@@ -0,0 +1,45 @@
+/**
+ * @file RequestScheduler.cpp
+ * @brief Priority queue of upstream requests with one request in flight implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/RequestScheduler.h"
+#include "utils/Logger.h"
+#include <array>
+
+void RequestScheduler::submit(RequestPriority priority,
+                              const std::string &label, Step step) {
+  queue_.push({priority, next_sequence_++, label, std::move(step)});
+}
+
+size_t RequestScheduler::run(const std::function<bool()> &stop) {
+  std::array<size_t, 3> steps_by_priority{};
+  size_t steps = 0;
+
+  while (!queue_.empty()) {
+    if (stop && stop()) {
+      spdlog::info("Scheduler stopped with {} entries queued", queue_.size());
+      break;
+    }
+
+    // Steps may submit new entries, so take this one off the queue first
+    Entry entry = queue_.top();
+    queue_.pop();
+
+    spdlog::debug("Scheduler: {} (priority {})", entry.label,
+                  static_cast<int>(entry.priority));
+    std::optional<RequestPriority> again = entry.step();
+    steps_by_priority[static_cast<size_t>(entry.priority)]++;
+    steps++;
+
+    if (again) {
+      submit(*again, entry.label, std::move(entry.step));
+    }
+  }
+
+  spdlog::info("Scheduler ran {} steps: {} recent, {} resumption, {} backfill",
+               steps, steps_by_priority[0], steps_by_priority[1],
+               steps_by_priority[2]);
+  return steps;
+}
@@ -0,0 +1,435 @@
+/**
+ * @file SnapshotImporter.cpp
+ * @brief Bootstrap load of the arXiv metadata JSON-lines snapshot
+ * implementation
+ * @author Bernard Chase
+ */
+
+#include "harvester/SnapshotImporter.h"
+#include "config/Config.h"
+#include "db/RecordTable.h"
+#include "harvester/BackfillPlanner.h"
+#include "utils/Logger.h"
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+namespace {
+
+// Rows per COPY stream, as in the archive loader
+constexpr long kStreamRows = 20000;
+
+// Chunks per parser: enough that a slow chunk does not leave the other
+// parsers idle at the end
+constexpr size_t kChunksPerParser = 16;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Titles and abstracts are hard-wrapped in the snapshot; oai_dc has them
+// on one line
+std::string collapseWhitespace(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  bool space = false;
+  for (char c : text) {
+    if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+      space = !out.empty();
+    } else {
+      if (space) {
+        out += ' ';
+        space = false;
+      }
+      out += c;
+    }
+  }
+  return out;
+}
+
+// "Mon, 2 Apr 2007 19:18:42 GMT" -> "2007-04-02"; empty if unrecognized
+std::string versionDate(const std::string &created) {
+  static const char *kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  int day = 0, year = 0;
+  char month_name[4] = {};
+  if (std::sscanf(created.c_str(), "%*3s, %d %3s %d", &day, month_name,
+                  &year) != 3) {
+    return "";
+  }
+  for (int m = 0; m < 12; ++m) {
+    if (std::strcmp(month_name, kMonths[m]) == 0) {
+      char date[40];
+      std::snprintf(date, sizeof(date), "%04d-%02d-%02d", year, m + 1, day);
+      return date;
+    }
+  }
+  return "";
+}
+
+// OAI-PMH top-level set of an arXiv archive; the physics group holds
+// every archive without a group of its own
+std::string groupOf(std::string_view archive) {
+  static const char *kGroups[] = {"cs",  "math", "q-bio", "q-fin",
+                                  "stat", "eess", "econ"};
+  for (const char *group : kGroups) {
+    if (archive == group) {
+      return group;
+    }
+  }
+  // Retired archives folded into cs and math
+  if (archive == "cmp-lg") {
+    return "cs";
+  }
+  if (archive == "alg-geom" || archive == "dg-ga" || archive == "funct-an" ||
+      archive == "q-alg") {
+    return "math";
+  }
+  return "physics";
+}
+
+std::string previousDay(const std::string &day) {
+  using namespace std::chrono;
+  int y = 0;
+  unsigned m = 0, d = 0;
+  if (std::sscanf(day.c_str(), "%d-%u-%u", &y, &m, &d) != 3) {
+    return "";
+  }
+  year_month_day date{sys_days{std::chrono::year{y} / month{m} / d} -
+                      days{1}};
+  char out[40];
+  std::snprintf(out, sizeof(out), "%04d-%02u-%02u", int(date.year()),
+                unsigned(date.month()), unsigned(date.day()));
+  return out;
+}
+
+} // namespace
+
+SnapshotImporter::SnapshotImporter(Database &db, std::string table_name,
+                                   HarvestLog &harvest_log,
+                                   Watermarks &watermarks,
+                                   ColumnProfile profile,
+                                   PartitionScheme scheme)
+    : db_(db), table_(std::move(table_name)), harvest_log_(harvest_log),
+      watermarks_(watermarks), profile_(profile), scheme_(scheme),
+      next_chunk_(0) {
+  Config &config = Config::instance();
+  setParsers(config.getLoadParsers());
+  setConnections(config.getLoadConnections());
+}
+
+void SnapshotImporter::setParsers(int parsers) {
+  // 0 means one per core
+  parsers_ = parsers > 0
+                 ? parsers
+                 : std::max(1, static_cast<int>(
+                                   std::thread::hardware_concurrency()));
+}
+
+void SnapshotImporter::setConnections(int connections) {
+  connections_ = std::max(1, connections);
+}
+
+std::vector<std::string>
+SnapshotImporter::setSpecsFor(std::string_view categories) {
+  std::vector<std::string> specs;
+  size_t pos = 0;
+  while (pos < categories.size()) {
+    size_t end = categories.find(' ', pos);
+    if (end == std::string_view::npos) {
+      end = categories.size();
+    }
+    std::string_view category = categories.substr(pos, end - pos);
+    pos = end + 1;
+    if (category.empty()) {
+      continue;
+    }
+
+    // cs.AI -> cs:cs:AI, astro-ph.GA -> physics:astro-ph:GA,
+    // hep-ph -> physics:hep-ph
+    size_t dot = category.find('.');
+    std::string_view archive = category.substr(0, dot);
+    std::string spec = groupOf(archive) + ":" + std::string(archive);
+    if (dot != std::string_view::npos) {
+      spec += ":" + std::string(category.substr(dot + 1));
+    }
+    if (std::find(specs.begin(), specs.end(), spec) == specs.end()) {
+      specs.push_back(std::move(spec));
+    }
+  }
+  return specs;
+}
+
+bool SnapshotImporter::mapLine(std::string_view line, Record &record) {
+  if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+    return false;
+  }
+
+  const nlohmann::json doc = nlohmann::json::parse(line.begin(), line.end());
+  auto text = [&](const char *key) {
+    auto it = doc.find(key);
+    return it != doc.end() && it->is_string() ? it->get<std::string>()
+                                               : std::string();
+  };
+
+  const std::string id = text("id");
+  if (id.empty()) {
+    throw std::runtime_error("snapshot entry without an id");
+  }
+
+  record = Record{};
+  record.header_identifier = "oai:arXiv.org:" + id;
+  record.header_datestamp = text("update_date");
+
+  const std::string categories = text("categories");
+  record.header_setSpecs = setSpecsFor(categories);
+
+  // authors_parsed holds [last, first, suffix]; oai_dc has "Last, First"
+  auto authors = doc.find("authors_parsed");
+  if (authors != doc.end() && authors->is_array()) {
+    for (const auto &author : *authors) {
+      if (!author.is_array() || author.empty() || !author[0].is_string()) {
+        continue;
+      }
+      std::string name = author[0].get<std::string>();
+      for (size_t i = 1; i < author.size() && i < 3; ++i) {
+        if (author[i].is_string() && !author[i].get<std::string>().empty()) {
+          name += ", " + author[i].get<std::string>();
+        }
+      }
+      record.metadata_creator.push_back(std::move(name));
+    }
+  } else if (!text("authors").empty()) {
+    record.metadata_creator.push_back(collapseWhitespace(text("authors")));
+  }
+
+  auto versions = doc.find("versions");
+  if (versions != doc.end() && versions->is_array()) {
+    for (const auto &version : *versions) {
+      auto created = version.find("created");
+      if (created != version.end() && created->is_string()) {
+        std::string date = versionDate(created->get<std::string>());
+        if (!date.empty()) {
+          record.metadata_date.push_back(std::move(date));
+        }
+      }
+    }
+  }
+
+  record.metadata_description = collapseWhitespace(text("abstract"));
+
+  record.metadata_identifier.push_back("http://arxiv.org/abs/" + id);
+  if (!text("journal-ref").empty()) {
+    record.metadata_identifier.push_back(text("journal-ref"));
+  }
+  if (!text("doi").empty()) {
+    record.metadata_identifier.push_back("doi:" + text("doi"));
+  }
+
+  // The snapshot carries category codes, not their display names
+  size_t pos = 0;
+  while (pos < categories.size()) {
+    size_t end = std::min(categories.find(' ', pos), categories.size());
+    if (end > pos) {
+      record.metadata_subject.push_back(categories.substr(pos, end - pos));
+    }
+    pos = end + 1;
+  }
+
+  record.metadata_title.push_back(collapseWhitespace(text("title")));
+  record.metadata_type = "text";
+  return true;
+}
+
+long SnapshotImporter::run(const std::string &path,
+                           const std::vector<std::string> &set_specs) {
+  stages_.clear();
+  Config &config = Config::instance();
+
+  // Map: cut the file into line-aligned chunks without reading it
+  auto map_started = std::chrono::steady_clock::now();
+  MappedFile file(path);
+  const std::string_view data = file.view();
+  const size_t chunks = static_cast<size_t>(parsers_) * kChunksPerParser;
+  std::vector<size_t> bounds{0};
+  for (size_t i = 1; i < chunks; ++i) {
+    size_t pos = std::max(data.size() / chunks * i, bounds.back());
+    pos = data.find('\n', pos);
+    bounds.push_back(pos == std::string_view::npos ? data.size() : pos + 1);
+  }
+  bounds.push_back(data.size());
+  stages_.push_back({"map", 0, static_cast<long>(data.size()),
+                     secondsSince(map_started)});
+
+  spdlog::info("Importing snapshot {} ({:.1f} MB) with {} parsers and {} "
+               "COPY connections",
+               path, data.size() / 1e6, parsers_, connections_);
+
+  BulkLoader bulk(config.getPostgresSchema(), table_, scheme_, connections_);
+  bulk.start();
+
+  auto parse_started = std::chrono::steady_clock::now();
+  next_chunk_ = 0;
+  std::vector<Tally> tallies(static_cast<size_t>(parsers_));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < tallies.size(); ++i) {
+    threads.emplace_back([&, i] {
+      parseWorker(data, bounds, set_specs, bulk, tallies[i]);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const bool complete = !interrupted();
+
+  Tally total;
+  for (const auto &tally : tallies) {
+    for (const auto &[set_spec, counts] : tally.set_day_counts) {
+      for (const auto &[day, count] : counts) {
+        total.set_day_counts[set_spec][day] += count;
+      }
+    }
+    if (!tally.first_day.empty() &&
+        (total.first_day.empty() || tally.first_day < total.first_day)) {
+      total.first_day = tally.first_day;
+    }
+    total.last_day = std::max(total.last_day, tally.last_day);
+    total.lines += tally.lines;
+    total.records += tally.records;
+    total.dropped += tally.dropped;
+    total.malformed += tally.malformed;
+  }
+  stages_.push_back({"parse", total.records, static_cast<long>(data.size()),
+                     secondsSince(parse_started)});
+
+  // An interrupted import keeps the rows it staged but claims no coverage
+  bulk.finish(db_, [&] {
+    if (complete) {
+      recordCoverage(total, set_specs);
+    }
+  });
+
+  stages_.push_back(
+      {"copy", bulk.copiedRows(), bulk.copiedBytes(), bulk.copySeconds()});
+  stages_.push_back({"merge", bulk.copiedRows(), 0, bulk.mergeSeconds()});
+
+  spdlog::info("Snapshot import {}: {} of {} entries loaded, {} outside the "
+               "configured sets, {} malformed; snapshot runs {} to {}",
+               complete ? "completed" : "interrupted", bulk.copiedRows(),
+               total.lines, total.dropped, total.malformed, total.first_day,
+               total.last_day);
+  BulkLoader::logStages(stages_);
+  return bulk.copiedRows();
+}
+
+void SnapshotImporter::parseWorker(std::string_view data,
+                                   const std::vector<size_t> &bounds,
+                                   const std::vector<std::string> &set_specs,
+                                   BulkLoader &bulk, Tally &tally) {
+  CopyEncoder encoder;
+  auto submit = [&] {
+    long rows = static_cast<long>(encoder.rows());
+    encoder.finish();
+    bulk.submit(encoder.take(), rows);
+  };
+
+  Record record;
+  for (size_t c = next_chunk_++; c + 1 < bounds.size() && !interrupted();
+       c = next_chunk_++) {
+    size_t pos = bounds[c];
+    while (pos < bounds[c + 1]) {
+      size_t end = data.find('\n', pos);
+      if (end == std::string_view::npos || end > bounds[c + 1]) {
+        end = bounds[c + 1];
+      }
+      std::string_view line = data.substr(pos, end - pos);
+      const size_t offset = pos;
+      pos = end + 1;
+
+      try {
+        if (!mapLine(line, record)) {
+          continue;
+        }
+      } catch (const std::exception &e) {
+        if (++tally.malformed <= 5) {
+          spdlog::warn("Skipping malformed snapshot entry at byte {}: {}",
+                       offset, e.what());
+        }
+        continue;
+      }
+      tally.lines++;
+
+      std::string day = record.header_datestamp.substr(0, 10);
+      if (!day.empty()) {
+        if (tally.first_day.empty() || day < tally.first_day) {
+          tally.first_day = day;
+        }
+        tally.last_day = std::max(tally.last_day, day);
+      }
+
+      bool keep = false;
+      for (const auto &set_spec : set_specs) {
+        if (record.inSet(set_spec)) {
+          tally.set_day_counts[set_spec][day]++;
+          keep = true;
+        }
+      }
+      if (!keep) {
+        tally.dropped++;
+        continue;
+      }
+
+      RecordTable::encode(encoder, record, profile_);
+      tally.records++;
+      if (static_cast<long>(encoder.rows()) >= kStreamRows) {
+        submit();
+      }
+    }
+  }
+
+  if (encoder.rows() > 0) {
+    submit();
+  }
+}
+
+void SnapshotImporter::recordCoverage(
+    const Tally &tally, const std::vector<std::string> &set_specs) {
+  // The snapshot's last day may have been cut off mid-day; leave it to the
+  // first incremental harvest
+  const std::string through = previousDay(tally.last_day);
+  if (tally.first_day.empty() || through < tally.first_day) {
+    return;
+  }
+
+  const auto windows = BackfillPlanner::monthlyWindows(tally.first_day, through);
+  for (const auto &set_spec : set_specs) {
+    auto counts = tally.set_day_counts.find(set_spec);
+    for (const auto &range : windows) {
+      HarvestWindow window;
+      window.set_spec = set_spec;
+      window.from_date = range.from_date;
+      window.until_date = range.until_date;
+      long records = 0;
+      if (counts != tally.set_day_counts.end()) {
+        for (auto it = counts->second.lower_bound(range.from_date);
+             it != counts->second.end() && it->first <= range.until_date;
+             ++it) {
+          window.day_counts[it->first] = it->second;
+          records += it->second;
+        }
+      }
+      window.complete_list_size = records;
+      harvest_log_.recordComplete(window);
+    }
+  }
+  watermarks_.advance(set_specs, through);
+
+  spdlog::info("Harvest log and watermarks of {} sets now cover {} to {}",
+               set_specs.size(), tally.first_day, through);
+}
@@ -6,18 +6,47 @@
  */
 
 #include <CLI/CLI.hpp>
+#include <curl/curl.h>
+#include <libxml/parser.h>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "config/Config.h"
 #include "db/Database.h"
+#include "harvester/Daemon.h"
 #include "harvester/Harvester.h"
+#include "harvester/Mirror.h"
+#include "harvester/MultiHarvester.h"
 #include "oai/OaiClient.h"
 #include "utils/Logger.h"
 
+namespace {
+
+// libcurl and libxml2 set up their global state lazily, which is not
+// thread-safe on every build; do it once before any harvester thread starts
+// and tear it down after the last one has finished
+struct LibraryInit {
+  LibraryInit() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    xmlInitParser();
+  }
+  ~LibraryInit() {
+    xmlCleanupParser();
+    curl_global_cleanup();
+  }
+  LibraryInit(const LibraryInit &) = delete;
+  LibraryInit &operator=(const LibraryInit &) = delete;
+};
+
+} // namespace
+
 int main(int argc, char **argv) {
+  LibraryInit libraries;
+
   // Initialize configuration
   Config &config = Config::instance();
   config.load();
@@ -29,8 +58,13 @@ int main(int argc, char **argv) {
   CLI::App app{"arXiv Academic Paper Metadata Harvester - C++ Implementation"};
 
   std::string mode = "recent";
-  app.add_option("-m,--mode", mode, "Harvest mode: recent, backfill, or both")
-      ->check(CLI::IsMember({"recent", "backfill", "both"}));
+  app.add_option("-m,--mode", mode,
+                 "Harvest mode: recent, incremental, backfill, both, verify, "
+                 "enqueue, worker, daemon, mirror, load-archive or "
+                 "import-snapshot")
+      ->check(CLI::IsMember({"recent", "incremental", "backfill", "both",
+                             "verify", "enqueue", "worker", "daemon",
+                             "mirror", "load-archive", "import-snapshot"}));
 
   std::string start_date, end_date;
   app.add_option("--start-date", start_date,
@@ -42,44 +76,255 @@ int main(int argc, char **argv) {
       ->default_val(std::vector<std::string>{"physics", "math", "cs", "q-bio",
                                              "q-fin", "stat", "eess", "econ"});
 
+  std::string freeze_before;
+  app.add_option("--freeze-before", freeze_before,
+                 "Freeze partitions ending on or before this date (YYYY-MM-DD)");
+
+  bool setless = false;
+  app.add_flag("--setless", setless,
+               "Harvest without a set parameter and route records to the "
+               "configured sets client-side");
+
+  bool plan = false;
+  app.add_flag("--plan", plan,
+               "Print the backfill plan and its estimated cost without "
+               "harvesting");
+
+  std::string plan_json;
+  app.add_option("--plan-json", plan_json,
+                 "Write the backfill plan as JSON to this file (implies --plan)");
+
+  bool bulk_load = false;
+  app.add_flag("--bulk-load", bulk_load,
+               "Defer secondary index maintenance until the load finishes");
+
+  std::string repositories_file = config.getRepositoriesFile();
+  app.add_option("--repositories", repositories_file,
+                 "JSON registry of OAI-PMH repositories to harvest "
+                 "concurrently (overrides --set-specs)");
+
+  std::string archive_dir = config.getArchiveDir();
+  app.add_option("--archive-dir", archive_dir,
+                 "Raw page archive written by --mode mirror and read by "
+                 "--mode load-archive");
+
+  std::vector<std::string> sinks;
+  app.add_option("--sink", sinks,
+                 "Record sink, repeatable: postgres, ndjson:<file>, "
+                 "archive:<dir>, sqlite:<file> or columnar:<dir> (overrides "
+                 "RECORD_SINKS)");
+
+  std::string snapshot_file;
+  app.add_option("snapshot,--snapshot", snapshot_file,
+                 "arXiv metadata snapshot (JSON lines) for --mode "
+                 "import-snapshot");
+
   try {
     app.parse(argc, argv);
   } catch (const CLI::ParseError &e) {
     return app.exit(e);
   }
 
+  if (mode == "daemon" && bulk_load) {
+    spdlog::error("--bulk-load cannot be combined with --mode daemon");
+    return 1;
+  }
+
+  if (mode == "mirror" && (bulk_load || !freeze_before.empty() || plan ||
+                           !plan_json.empty())) {
+    spdlog::error("--mode mirror does not touch the database; drop "
+                  "--bulk-load, --freeze-before and --plan");
+    return 1;
+  }
+
+  if (mode == "import-snapshot" && snapshot_file.empty()) {
+    spdlog::error("--mode import-snapshot needs the snapshot file");
+    return 1;
+  }
+
+  if (!repositories_file.empty() &&
+      (mode == "daemon" || mode == "import-snapshot" || plan ||
+       !plan_json.empty())) {
+    spdlog::error("--repositories cannot be combined with --mode daemon, "
+                  "--mode import-snapshot or --plan");
+    return 1;
+  }
+
+  // One-shot modes, shared by the single- and multi-repository paths
+  auto runMode = [&](Harvester &harvester,
+                     const std::vector<std::string> &sets) {
+    int records = 0;
+
+    if (mode == "recent") {
+      spdlog::info("Starting recent harvest...");
+      records += harvester.harvestRecent(sets);
+    }
+
+    if (mode == "both") {
+      spdlog::info("Starting recent harvest and backfill...");
+      records += harvester.harvestRecentAndBackfill(start_date, end_date, sets);
+    }
+
+    if (mode == "incremental") {
+      spdlog::info("Starting incremental harvest...");
+      records += harvester.harvestIncremental(sets);
+    }
+
+    if (mode == "backfill") {
+      spdlog::info("Starting backfill...");
+      records += harvester.harvestBackfill(start_date, end_date, sets);
+    }
+
+    if (mode == "verify") {
+      spdlog::info("Starting completeness verification...");
+      records += harvester.verifyCompleteness(start_date, end_date, sets);
+    }
+
+    if (mode == "enqueue") {
+      spdlog::info("Queueing backfill jobs...");
+      harvester.enqueueBackfill(start_date, end_date, sets);
+    }
+
+    if (mode == "worker") {
+      spdlog::info("Working through queued jobs...");
+      harvester.setInterrupt(&Daemon::stopRequested);
+      records += harvester.harvestJobs(sets);
+    }
+
+    if (mode == "load-archive") {
+      spdlog::info("Loading the page archive...");
+      harvester.setInterrupt(&Daemon::stopRequested);
+      records += harvester.loadArchive(archive_dir, sets);
+    }
+
+    if (mode == "import-snapshot") {
+      spdlog::info("Importing the metadata snapshot...");
+      harvester.setInterrupt(&Daemon::stopRequested);
+      records += harvester.importSnapshot(snapshot_file, sets);
+    }
+
+    return records;
+  };
+
+  // Set locks taken and skipped, summed over repositories
+  LockStats lock_stats;
+  std::mutex lock_stats_mutex;
+
+  // Deferred index builds and partition freezing after a one-shot mode
+  auto finish = [&](Harvester &harvester) {
+    {
+      std::lock_guard<std::mutex> lock(lock_stats_mutex);
+      lock_stats.acquired += harvester.lockStats().acquired;
+      lock_stats.skipped += harvester.lockStats().skipped;
+      lock_stats.waited_ms += harvester.lockStats().waited_ms;
+    }
+
+    if (bulk_load) {
+      spdlog::info("Building deferred indexes...");
+      harvester.finishBulkLoad();
+    }
+
+    if (!freeze_before.empty()) {
+      spdlog::info("Freezing partitions before {}...", freeze_before);
+      harvester.freezePartitions(freeze_before);
+    }
+  };
+
   // Log startup
   spdlog::info("===========================================");
   spdlog::info("arXiv Harvester (C++) Starting");
   spdlog::info("Mode: {}", mode);
   spdlog::info("===========================================");
 
+  if (mode == "worker" || mode == "mirror" || mode == "load-archive" ||
+      mode == "import-snapshot") {
+    // A stopped worker hands its job back to the queue; mirror and loaders
+    // stop between windows or chunks
+    Daemon::installSignalHandlers();
+  }
+
+  // Network only: pages go to the archive, never to Postgres
+  auto runMirror = [&](const Repository &repository) {
+    Mirror mirror(repository, archive_dir);
+    mirror.setSetless(setless);
+    mirror.setInterrupt(&Daemon::stopRequested);
+    return static_cast<int>(
+        mirror.run(start_date, end_date, repository.set_specs));
+  };
+
   // Track execution time
   auto start_time = std::chrono::steady_clock::now();
 
   int total_records = 0;
 
+  size_t failed_repositories = 0;
+
   try {
-    // Initialize database connection
-    Database db;
-    db.connect();
+    if (!repositories_file.empty()) {
+      MultiHarvester multi(Repository::loadRegistry(repositories_file));
+      if (mode == "mirror") {
+        total_records = multi.runEach(runMirror);
+      } else {
+        total_records = multi.run(
+            [&](Harvester &harvester, const Repository &repository) {
+              harvester.setSetless(setless);
+              harvester.setBulkLoad(bulk_load);
+              if (!sinks.empty()) {
+                harvester.setSinks(sinks);
+              }
+              int records = runMode(harvester, repository.set_specs);
+              finish(harvester);
+              return records;
+            });
+      }
+      failed_repositories = multi.failures();
+    } else if (mode == "mirror") {
+      total_records = runMirror(Repository::fromConfig(set_specs));
+    } else {
+      // Initialize database connection
+      Database db;
+      db.connect();
 
-    // Initialize harvester
-    Harvester harvester(db);
+      // Initialize harvester
+      Harvester harvester(db);
+      harvester.setSetless(setless);
+      if (!sinks.empty()) {
+        harvester.setSinks(sinks);
+      }
 
-    if (mode == "recent" || mode == "both") {
-      spdlog::info("Starting recent harvest...");
-      total_records += harvester.harvestRecent(set_specs);
-    }
+      if (plan || !plan_json.empty()) {
+        // Dry run: nothing is fetched and no DDL or index build is issued
+        BackfillPlan backfill_plan =
+            harvester.planBackfill(start_date, end_date, set_specs);
+        backfill_plan.log();
+        if (!plan_json.empty()) {
+          std::ofstream out(plan_json);
+          if (!out) {
+            throw std::runtime_error("Cannot write plan to " + plan_json);
+          }
+          out << backfill_plan.toJson() << "\n";
+          spdlog::info("Plan written to {}", plan_json);
+        }
+        db.disconnect();
+        return 0;
+      }
 
-    if (mode == "backfill" || mode == "both") {
-      spdlog::info("Starting backfill...");
-      total_records +=
-          harvester.harvestBackfill(start_date, end_date, set_specs);
-    }
+      harvester.setBulkLoad(bulk_load);
+
+      if (mode == "daemon") {
+        Daemon::installSignalHandlers();
+        Daemon daemon(db, harvester, set_specs);
+        daemon.setBackfillRange(start_date, end_date);
+        total_records += daemon.run();
+      } else {
+        total_records += runMode(harvester, set_specs);
+      }
 
-    // Clean up
-    db.disconnect();
+      finish(harvester);
+
+      // Clean up
+      db.disconnect();
+    }
 
   } catch (const std::exception &e) {
     spdlog::error("Fatal error: {}", e.what());
@@ -95,11 +340,22 @@ int main(int argc, char **argv) {
   spdlog::info("HARVEST COMPLETED");
   spdlog::info("Total records processed: {}", total_records);
   spdlog::info("Time elapsed: {} seconds", duration.count());
+  if (lock_stats.acquired + lock_stats.skipped > 0) {
+    spdlog::info("Set locks: {} taken, {} skipped (held by another run), "
+                 "{} ms waiting",
+                 lock_stats.acquired, lock_stats.skipped,
+                 lock_stats.waited_ms);
+  }
   if (duration.count() > 0) {
     spdlog::info("Records per minute: {:.2f}",
                  (total_records * 60.0) / duration.count());
   }
   spdlog::info("===========================================");
 
+  if (failed_repositories > 0) {
+    spdlog::error("{} repositories failed", failed_repositories);
+    return 1;
+  }
+
   return 0;
 }
@@ -0,0 +1,249 @@
+/**
+ * @file EventLoop.cpp
+ * @brief Single-threaded curl multi event loop with coroutine awaitables implementation
+ * @author Bernard Chase
+ */
+
+#include "oai/EventLoop.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <poll.h>
+#include <stdexcept>
+#include <vector>
+
+// Fire-and-forget frame behind spawn(); it frees itself when done
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+EventLoop::EventLoop()
+    : multi_(curl_multi_init()), curl_timer_set_(false), tasks_(0) {
+  if (!multi_) {
+    throw std::runtime_error("Failed to create curl multi handle");
+  }
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socketCallback);
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timerCallback);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+}
+
+EventLoop::~EventLoop() {
+  // Suspended frames belong to their spawners; only transfers are cleaned up
+  for (CURL *easy : transfers_) {
+    curl_multi_remove_handle(multi_, easy);
+    curl_easy_cleanup(easy);
+  }
+  curl_multi_cleanup(multi_);
+}
+
+EventLoop::FetchAwaiter::FetchAwaiter(EventLoop &loop, std::string url,
+                                      long timeout_seconds)
+    : loop_(loop), url_(std::move(url)), timeout_seconds_(timeout_seconds) {}
+
+void EventLoop::FetchAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+  waiter_ = waiter;
+  loop_.start(*this);
+}
+
+void EventLoop::SleepAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+  loop_.timers_.emplace(until_, waiter);
+}
+
+EventLoop::FetchAwaiter EventLoop::fetch(std::string url,
+                                         long timeout_seconds) {
+  return FetchAwaiter(*this, std::move(url), timeout_seconds);
+}
+
+DetachedTask EventLoop::runDetached(EventLoop &loop, Task<void> task) {
+  try {
+    co_await task;
+  } catch (const std::exception &e) {
+    spdlog::error("Async task failed: {}", e.what());
+  }
+  loop.tasks_--;
+}
+
+void EventLoop::spawn(Task<void> task) {
+  tasks_++;
+  // Runs up to its first suspension right away
+  runDetached(*this, std::move(task));
+}
+
+void EventLoop::start(FetchAwaiter &awaiter) {
+  CURL *easy = curl_easy_init();
+  if (!easy) {
+    awaiter.response_.error = "Failed to create curl handle";
+    ready_.push_back(awaiter.waiter_);
+    return;
+  }
+
+  curl_easy_setopt(easy, CURLOPT_URL, awaiter.url_.c_str());
+  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(easy, CURLOPT_MAXREDIRS, 5L);
+  curl_easy_setopt(easy, CURLOPT_TIMEOUT, awaiter.timeout_seconds_);
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &awaiter.response_);
+  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, headerCallback);
+  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &awaiter.response_);
+  curl_easy_setopt(easy, CURLOPT_PRIVATE, &awaiter);
+
+  CURLMcode rc = curl_multi_add_handle(multi_, easy);
+  if (rc != CURLM_OK) {
+    curl_easy_cleanup(easy);
+    awaiter.response_.error = curl_multi_strerror(rc);
+    ready_.push_back(awaiter.waiter_);
+    return;
+  }
+  transfers_.insert(easy);
+}
+
+size_t EventLoop::writeCallback(char *data, size_t size, size_t nmemb,
+                                void *userp) {
+  static_cast<HttpResponse *>(userp)->body.append(data, size * nmemb);
+  return size * nmemb;
+}
+
+size_t EventLoop::headerCallback(char *data, size_t size, size_t nmemb,
+                                 void *userp) {
+  std::string line(data, size * nmemb);
+  static const std::string name = "retry-after:";
+  if (line.size() > name.size()) {
+    std::string prefix = line.substr(0, name.size());
+    std::transform(prefix.begin(), prefix.end(), prefix.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (prefix == name) {
+      // Only the delay-seconds form; an HTTP date leaves it unset
+      try {
+        static_cast<HttpResponse *>(userp)->retry_after =
+            std::stoi(line.substr(name.size()));
+      } catch (const std::exception &) {
+      }
+    }
+  }
+  return size * nmemb;
+}
+
+int EventLoop::socketCallback(CURL *, curl_socket_t socket, int what,
+                              void *userp, void *) {
+  auto *loop = static_cast<EventLoop *>(userp);
+  if (what == CURL_POLL_REMOVE) {
+    loop->sockets_.erase(socket);
+  } else {
+    loop->sockets_[socket] = what;
+  }
+  return 0;
+}
+
+int EventLoop::timerCallback(CURLM *, long timeout_ms, void *userp) {
+  auto *loop = static_cast<EventLoop *>(userp);
+  loop->curl_timer_set_ = timeout_ms >= 0;
+  loop->curl_deadline_ = Clock::now() + std::chrono::milliseconds(timeout_ms);
+  return 0;
+}
+
+void EventLoop::collectFinished() {
+  int pending = 0;
+  while (CURLMsg *message = curl_multi_info_read(multi_, &pending)) {
+    if (message->msg != CURLMSG_DONE) {
+      continue;
+    }
+
+    CURL *easy = message->easy_handle;
+    FetchAwaiter *awaiter = nullptr;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &awaiter);
+
+    if (message->data.result != CURLE_OK) {
+      awaiter->response_.error = curl_easy_strerror(message->data.result);
+    }
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE,
+                      &awaiter->response_.status);
+
+    curl_multi_remove_handle(multi_, easy);
+    curl_easy_cleanup(easy);
+    transfers_.erase(easy);
+    ready_.push_back(awaiter->waiter_);
+  }
+}
+
+void EventLoop::pollOnce() {
+  auto now = Clock::now();
+
+  // Sleep until the first socket event, curl timeout or task timer, and at
+  // most a second so a stalled transfer cannot hang the loop
+  auto wake = now + std::chrono::seconds(1);
+  if (curl_timer_set_) {
+    wake = std::min(wake, curl_deadline_);
+  }
+  if (!timers_.empty()) {
+    wake = std::min(wake, timers_.begin()->first);
+  }
+  int timeout_ms = static_cast<int>(std::max<long>(
+      0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now)
+             .count()));
+
+  std::vector<pollfd> fds;
+  fds.reserve(sockets_.size());
+  for (const auto &[socket, what] : sockets_) {
+    short events = 0;
+    if (what == CURL_POLL_IN || what == CURL_POLL_INOUT) {
+      events |= POLLIN;
+    }
+    if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT) {
+      events |= POLLOUT;
+    }
+    fds.push_back({socket, events, 0});
+  }
+
+  int running = 0;
+  if (poll(fds.data(), fds.size(), timeout_ms) > 0) {
+    for (const auto &fd : fds) {
+      int flags = 0;
+      if (fd.revents & POLLIN) {
+        flags |= CURL_CSELECT_IN;
+      }
+      if (fd.revents & POLLOUT) {
+        flags |= CURL_CSELECT_OUT;
+      }
+      if (fd.revents & (POLLERR | POLLHUP)) {
+        flags |= CURL_CSELECT_ERR;
+      }
+      if (flags) {
+        curl_multi_socket_action(multi_, fd.fd, flags, &running);
+      }
+    }
+  }
+
+  if (curl_timer_set_ && Clock::now() >= curl_deadline_) {
+    curl_timer_set_ = false;
+    curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+  }
+  collectFinished();
+
+  now = Clock::now();
+  while (!timers_.empty() && timers_.begin()->first <= now) {
+    ready_.push_back(timers_.begin()->second);
+    timers_.erase(timers_.begin());
+  }
+}
+
+void EventLoop::run() {
+  while (true) {
+    // Resumed tasks may start transfers or timers, or finish
+    while (!ready_.empty()) {
+      std::coroutine_handle<> handle = ready_.front();
+      ready_.pop_front();
+      handle.resume();
+    }
+    if (tasks_ == 0) {
+      break;
+    }
+    pollOnce();
+  }
+}
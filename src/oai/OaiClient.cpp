@@ -6,19 +6,15 @@
 
 #include "oai/OaiClient.h"
 #include "config/Config.h"
+#include "harvester/RateLimiter.h"
 #include "utils/Logger.h"
-#include <chrono>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include <sstream>
-#include <thread>
-
-// Global string for CURL callback
-static std::string response_buffer;
 
 OaiClient::OaiClient(const std::string &base_url)
-    : base_url_(base_url), curl_(nullptr), rate_limit_delay_(3),
-      max_retries_(3) {
+    : base_url_(base_url), curl_(nullptr), max_retries_(3),
+      rate_limiter_(std::make_shared<RateLimiter>(3)) {
   curl_ = curl_easy_init();
   
   // Set up CURL to follow redirects properly
@@ -33,24 +29,24 @@ OaiClient::~OaiClient() {
 }
 
 void OaiClient::setRateLimitDelay(int delay_seconds) {
-  rate_limit_delay_ = delay_seconds;
+  rate_limiter_ = std::make_shared<RateLimiter>(delay_seconds);
 }
 
-void OaiClient::setMaxRetries(int max_retries) { max_retries_ = max_retries; }
-
-size_t OaiClient::writeCallback(void *contents, size_t size, size_t nmemb,
-                                void *userp) {
-  size_t realsize = size * nmemb;
-  response_buffer.append(static_cast<char *>(contents), realsize);
-  return realsize;
+void OaiClient::setRateLimiter(std::shared_ptr<RateLimiter> limiter) {
+  rate_limiter_ = std::move(limiter);
 }
 
+void OaiClient::setMaxRetries(int max_retries) { max_retries_ = max_retries; }
+
 std::string OaiClient::fetchUrl(const std::string &url) {
-  response_buffer.clear();
+  // Per-call buffer: clients on different threads must not share one
+  HttpResponse response;
 
   curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_buffer);
+  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, EventLoop::writeCallback);
+  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
+  curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, EventLoop::headerCallback);
+  curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &response);
   curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
   curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 60L);
 
@@ -61,29 +57,62 @@ std::string OaiClient::fetchUrl(const std::string &url) {
     throw std::runtime_error("Failed to fetch URL");
   }
 
-  long response_code;
-  curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response_code);
+  curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response.status);
 
-  if (response_code >= 400) {
-    spdlog::error("HTTP error: {}", response_code);
+  if (response.status >= 400) {
+    spdlog::error("HTTP error: {}", response.status);
+    honourRetryAfter(response);
     throw std::runtime_error("HTTP request failed");
   }
 
-  return response_buffer;
+  return std::move(response.body);
+}
+
+void OaiClient::honourRetryAfter(const HttpResponse &response) {
+  if (response.retry_after > 0) {
+    spdlog::warn("Server asked to retry after {} s", response.retry_after);
+    rate_limiter_->defer(std::chrono::steady_clock::now() +
+                         std::chrono::seconds(response.retry_after));
+  }
 }
 
 void OaiClient::rateLimitWait() {
-  std::this_thread::sleep_for(std::chrono::seconds(rate_limit_delay_));
+  // Request starts are spaced by the limiter, which may be shared with
+  // other clients of the same host
+  rate_limiter_->wait_before_request();
 }
 
-std::vector<Record> OaiClient::listRecords(const std::string &metadata_prefix,
-                                           const std::string &set_spec,
-                                           const std::string &from_date,
-                                           const std::string &until_date) {
+std::string OaiClient::fetchWithRetries(const std::string &url) {
+  spdlog::info("Fetching records from: {}", url);
+
+  // Wait before request (rate limiting)
+  rateLimitWait();
+
+  int retries = 0;
+
+  while (true) {
+    try {
+      return fetchUrl(url);
+    } catch (const std::exception &e) {
+      retries++;
+      spdlog::warn("Request failed (attempt {}/{}): {}", retries, max_retries_,
+                   e.what());
+      if (retries >= max_retries_) {
+        throw;
+      }
+      rateLimitWait();
+    }
+  }
+}
 
+std::string OaiClient::listUrl(const std::string &verb,
+                               const std::string &metadata_prefix,
+                               const std::string &set_spec,
+                               const std::string &from_date,
+                               const std::string &until_date) const {
   // Build OAI-PMH request URL
   std::stringstream url;
-  url << base_url_ << "?verb=ListRecords";
+  url << base_url_ << "?verb=" << verb;
   url << "&metadataPrefix=" << metadata_prefix;
   if (!set_spec.empty()) {
     url << "&set=" << set_spec;
@@ -94,107 +123,238 @@ std::vector<Record> OaiClient::listRecords(const std::string &metadata_prefix,
   if (!until_date.empty()) {
     url << "&until=" << until_date;
   }
+  return url.str();
+}
+
+std::string OaiClient::resumeUrl(const std::string &resumption_token) const {
+  char *escaped = curl_easy_escape(curl_, resumption_token.c_str(),
+                                   static_cast<int>(resumption_token.size()));
+  std::string url =
+      base_url_ + "?verb=ListRecords&resumptionToken=" + std::string(escaped);
+  curl_free(escaped);
+  return url;
+}
 
-  spdlog::info("Fetching records from: {}", url.str());
+OaiPage OaiClient::listRecordsPage(const std::string &metadata_prefix,
+                                   const std::string &set_spec,
+                                   const std::string &from_date,
+                                   const std::string &until_date) {
+  return parseXmlResponse(fetchWithRetries(
+      listUrl("ListRecords", metadata_prefix, set_spec, from_date, until_date)));
+}
 
-  // Wait before request (rate limiting)
-  rateLimitWait();
+OaiPage OaiClient::resumeListRecords(const std::string &resumption_token) {
+  return parseXmlResponse(fetchWithRetries(resumeUrl(resumption_token)));
+}
+
+OaiPage OaiClient::listIdentifiersPage(const std::string &metadata_prefix,
+                                       const std::string &set_spec,
+                                       const std::string &from_date,
+                                       const std::string &until_date) {
+  return parseXmlResponse(fetchWithRetries(listUrl(
+      "ListIdentifiers", metadata_prefix, set_spec, from_date, until_date)));
+}
+
+Task<std::string> OaiClient::fetch(EventLoop &loop, std::string url) {
+  spdlog::info("Fetching records from: {}", url);
 
-  std::string xml_response;
   int retries = 0;
+  while (true) {
+    // The slot is booked now; only this task waits for it
+    co_await loop.sleepUntil(rate_limiter_->reserve());
 
-  while (retries < max_retries_) {
-    try {
-      xml_response = fetchUrl(url.str());
+    HttpResponse response = co_await loop.fetch(url);
+    if (response.ok()) {
+      co_return std::move(response.body);
+    }
+
+    honourRetryAfter(response);
+    retries++;
+    std::string error = response.error.empty()
+                            ? "HTTP error " + std::to_string(response.status)
+                            : response.error;
+    spdlog::warn("Request failed (attempt {}/{}): {}", retries, max_retries_,
+                 error);
+    if (retries >= max_retries_) {
+      throw std::runtime_error("HTTP request failed: " + error);
+    }
+  }
+}
+
+Task<OaiPage> OaiClient::listRecordsPageAsync(EventLoop &loop,
+                                              std::string metadata_prefix,
+                                              std::string set_spec,
+                                              std::string from_date,
+                                              std::string until_date) {
+  std::string xml = co_await fetch(
+      loop,
+      listUrl("ListRecords", metadata_prefix, set_spec, from_date, until_date));
+  co_return parseXmlResponse(xml);
+}
+
+Task<OaiPage> OaiClient::resumeListRecordsAsync(EventLoop &loop,
+                                                std::string resumption_token) {
+  std::string xml = co_await fetch(loop, resumeUrl(resumption_token));
+  co_return parseXmlResponse(xml);
+}
+
+Task<OaiPage> OaiClient::listIdentifiersPageAsync(EventLoop &loop,
+                                                  std::string metadata_prefix,
+                                                  std::string set_spec,
+                                                  std::string from_date,
+                                                  std::string until_date) {
+  std::string xml = co_await fetch(loop, listUrl("ListIdentifiers",
+                                                 metadata_prefix, set_spec,
+                                                 from_date, until_date));
+  co_return parseXmlResponse(xml);
+}
+
+std::vector<Record> OaiClient::listRecords(const std::string &metadata_prefix,
+                                           const std::string &set_spec,
+                                           const std::string &from_date,
+                                           const std::string &until_date) {
+  std::vector<Record> records;
+
+  OaiPage page =
+      listRecordsPage(metadata_prefix, set_spec, from_date, until_date);
+  while (true) {
+    records.insert(records.end(), std::make_move_iterator(page.records.begin()),
+                   std::make_move_iterator(page.records.end()));
+    if (page.resumption_token.empty()) {
       break;
-    } catch (const std::exception &e) {
-      retries++;
-      spdlog::warn("Request failed (attempt {}/{}): {}", retries, max_retries_,
-                   e.what());
-      if (retries < max_retries_) {
-        rateLimitWait();
-      }
     }
+    page = resumeListRecords(page.resumption_token);
   }
 
-  if (xml_response.empty()) {
+  if (records.empty()) {
     spdlog::warn("No records found for set_spec: {}, from: {}, until: {}",
                  set_spec, from_date, until_date);
-    return {};
   }
 
-  return parseXmlResponse(xml_response);
+  return records;
 }
 
-std::vector<Record> OaiClient::parseXmlResponse(const std::string &xml) {
-  std::vector<Record> records;
+OaiPage OaiClient::parseXmlResponse(std::string_view xml) {
+  OaiPage page;
+  std::vector<Record> &records = page.records;
 
   auto isElementNamed = [](xmlNodePtr node, const char *name) {
     return node && node->type == XML_ELEMENT_NODE &&
            xmlStrcmp(node->name, reinterpret_cast<const xmlChar *>(name)) == 0;
   };
 
-  xmlDocPtr doc = xmlReadMemory(xml.c_str(), xml.size(), "noname.xml", NULL, 0);
+  xmlDocPtr doc = xmlReadMemory(xml.data(), static_cast<int>(xml.size()),
+                                "noname.xml", NULL, 0);
   if (!doc) {
     spdlog::error("Failed to parse XML response");
-    return records;
+    throw std::runtime_error("Malformed OAI-PMH response");
   }
 
   xmlNodePtr root = xmlDocGetRootElement(doc);
   if (!root) {
     xmlFreeDoc(doc);
-    return records;
+    throw std::runtime_error("Empty OAI-PMH response");
   }
 
   if (root->ns && root->ns->href) {
     spdlog::debug("XML default namespace: {}", (const char *)root->ns->href);
   }
 
-  // OAI-PMH structure is OAI-PMH -> ListRecords -> record
+  // OAI-PMH structure is OAI-PMH -> ListRecords -> record, or
+  // OAI-PMH -> ListIdentifiers -> header for identifier listings
   xmlNodePtr list_records = nullptr;
   for (xmlNodePtr node = root->children; node; node = node->next) {
-    if (isElementNamed(node, "ListRecords")) {
+    if (isElementNamed(node, "ListRecords") ||
+        isElementNamed(node, "ListIdentifiers")) {
       list_records = node;
       break;
     }
+    if (isElementNamed(node, "error")) {
+      // noRecordsMatch is a successful, empty answer; anything else is not
+      xmlChar *code = xmlGetProp(node, reinterpret_cast<const xmlChar *>("code"));
+      std::string error_code = code ? (const char *)code : "";
+      xmlFree(code);
+      xmlFreeDoc(doc);
+      if (error_code == "noRecordsMatch") {
+        return page;
+      }
+      spdlog::error("OAI-PMH error: {}", error_code);
+      throw std::runtime_error("OAI-PMH error: " + error_code);
+    }
   }
 
   if (!list_records) {
     spdlog::warn("No <ListRecords> element found in OAI-PMH response");
     xmlFreeDoc(doc);
-    return records;
+    return page;
   }
 
+  auto parseHeader = [&](xmlNodePtr header, Record &record) {
+    for (xmlNodePtr header_child = header->children; header_child;
+         header_child = header_child->next) {
+      if (isElementNamed(header_child, "identifier")) {
+        xmlChar *content = xmlNodeGetContent(header_child);
+        if (content) {
+          record.header_identifier = (const char *)content;
+          xmlFree(content);
+        }
+      } else if (isElementNamed(header_child, "datestamp")) {
+        xmlChar *content = xmlNodeGetContent(header_child);
+        if (content) {
+          record.header_datestamp = (const char *)content;
+          xmlFree(content);
+        }
+      } else if (isElementNamed(header_child, "setSpec")) {
+        xmlChar *content = xmlNodeGetContent(header_child);
+        if (content) {
+          record.header_setSpecs.push_back((const char *)content);
+          xmlFree(content);
+        }
+      }
+    }
+  };
+
   // Find all record nodes under <ListRecords>
   for (xmlNodePtr node = list_records->children; node; node = node->next) {
+    if (isElementNamed(node, "resumptionToken")) {
+      auto attribute = [&](const char *name) {
+        xmlChar *value =
+            xmlGetProp(node, reinterpret_cast<const xmlChar *>(name));
+        std::string result = value ? (const char *)value : "";
+        xmlFree(value);
+        return result;
+      };
+
+      xmlChar *content = xmlNodeGetContent(node);
+      if (content) {
+        page.resumption_token = (const char *)content;
+        xmlFree(content);
+      }
+      std::string list_size = attribute("completeListSize");
+      std::string cursor = attribute("cursor");
+      page.complete_list_size = list_size.empty() ? -1 : std::stol(list_size);
+      page.cursor = cursor.empty() ? -1 : std::stol(cursor);
+      page.token_expiration = attribute("expirationDate");
+      continue;
+    }
+
+    // ListIdentifiers: bare headers, no metadata
+    if (isElementNamed(node, "header")) {
+      Record record;
+      parseHeader(node, record);
+      if (!record.header_identifier.empty()) {
+        records.push_back(std::move(record));
+      }
+      continue;
+    }
+
     if (isElementNamed(node, "record")) {
       Record record;
 
       // Parse header
       for (xmlNodePtr child = node->children; child; child = child->next) {
         if (isElementNamed(child, "header")) {
-          for (xmlNodePtr header_child = child->children; header_child;
-               header_child = header_child->next) {
-            if (isElementNamed(header_child, "identifier")) {
-              xmlChar *content = xmlNodeGetContent(header_child);
-              if (content) {
-                record.header_identifier = (const char *)content;
-                xmlFree(content);
-              }
-            } else if (isElementNamed(header_child, "datestamp")) {
-              xmlChar *content = xmlNodeGetContent(header_child);
-              if (content) {
-                record.header_datestamp = (const char *)content;
-                xmlFree(content);
-              }
-            } else if (isElementNamed(header_child, "setSpec")) {
-              xmlChar *content = xmlNodeGetContent(header_child);
-              if (content) {
-                record.header_setSpecs.push_back((const char *)content);
-                xmlFree(content);
-              }
-            }
-          }
+          parseHeader(child, record);
         }
         // Parse metadata (Dublin Core)
         else if (isElementNamed(child, "metadata")) {
@@ -243,7 +403,7 @@ std::vector<Record> OaiClient::parseXmlResponse(const std::string &xml) {
   }
 
   xmlFreeDoc(doc);
-  spdlog::info("Parsed {} records from XML", records.size());
+  spdlog::debug("Parsed {} records from XML", records.size());
 
-  return records;
+  return page;
 }
@@ -0,0 +1,54 @@
+/**
+ * @file ArchiveSink.cpp
+ * @brief Record sink keeping a month-partitioned NDJSON archive
+ * implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/ArchiveSink.h"
+#include "sink/NdjsonSink.h"
+#include "utils/FileSync.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+ArchiveSink::ArchiveSink(std::string dir)
+    : dir_(std::move(dir)), watermarks_(dir_ + "/watermark.json") {}
+
+std::string ArchiveSink::name() const { return "archive " + dir_; }
+
+void ArchiveSink::writeBatch(const std::vector<Record> &records) {
+  for (const auto &record : records) {
+    // Records without a usable datestamp still need a home
+    const std::string month = record.header_datestamp.size() >= 7
+                                  ? record.header_datestamp.substr(0, 7)
+                                  : "undated";
+    std::string &lines = pending_[month];
+    NdjsonSink::appendJson(lines, record);
+    lines.push_back('\n');
+  }
+}
+
+void ArchiveSink::flush() {
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    const std::string &month = it->first;
+    fs::path dir = fs::path(dir_) / month.substr(0, 4);
+    if (fs::create_directories(dir)) {
+      // A new year directory (and maybe the archive root) must itself
+      // survive a power loss for the file appended below to be found
+      FileSync::syncDirectory(dir_);
+      FileSync::syncDirectory(fs::absolute(dir_).parent_path().string());
+    }
+    fs::path file = dir / (month + ".ndjson");
+
+    // Months written before a failure are done; the failed one is cut back
+    // and kept for the retry
+    NdjsonSink::appendFile(file.string(), it->second);
+    it = pending_.erase(it);
+  }
+}
+
+void ArchiveSink::commitWatermark(const std::vector<std::string> &set_specs,
+                                  const std::string &day) {
+  watermarks_.advance(set_specs, day);
+}
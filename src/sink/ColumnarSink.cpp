@@ -0,0 +1,100 @@
+/**
+ * @file ColumnarSink.cpp
+ * @brief Record sink exporting column-major row groups implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/ColumnarSink.h"
+#include "utils/FileSync.h"
+#include "utils/JsonHelper.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// File names of the columns, in RecordTable order
+const char *const kColumns[] = {
+    "header_datestamp",     "header_identifier",   "header_setSpecs",
+    "metadata_creator",     "metadata_date",       "metadata_description",
+    "metadata_identifier",  "metadata_subject",    "metadata_title",
+    "metadata_type"};
+constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+std::string partName(int part) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "part-%06d", part);
+  return name;
+}
+
+} // namespace
+
+ColumnarSink::ColumnarSink(std::string dir)
+    : dir_(std::move(dir)), next_part_(0), rows_(0), columns_(kColumnCount),
+      watermarks_(dir_ + "/watermark.json") {
+  if (fs::create_directories(dir_)) {
+    FileSync::syncDirectory(fs::absolute(dir_).parent_path().string());
+  }
+
+  // Continue numbering after the row groups of earlier runs
+  for (const auto &entry : fs::directory_iterator(dir_)) {
+    const std::string name = entry.path().filename().string();
+    int part = 0;
+    if (entry.is_directory() && std::sscanf(name.c_str(), "part-%d", &part) == 1) {
+      next_part_ = std::max(next_part_, part + 1);
+    }
+  }
+}
+
+std::string ColumnarSink::name() const { return "columnar " + dir_; }
+
+void ColumnarSink::writeBatch(const std::vector<Record> &records) {
+  for (const auto &record : records) {
+    JsonHelper::appendQuoted(columns_[0], record.header_datestamp);
+    JsonHelper::appendQuoted(columns_[1], record.header_identifier);
+    JsonHelper::appendStringArray(columns_[2], record.header_setSpecs);
+    JsonHelper::appendStringArray(columns_[3], record.metadata_creator);
+    JsonHelper::appendStringArray(columns_[4], record.metadata_date);
+    JsonHelper::appendQuoted(columns_[5], record.metadata_description);
+    JsonHelper::appendStringArray(columns_[6], record.metadata_identifier);
+    JsonHelper::appendStringArray(columns_[7], record.metadata_subject);
+    JsonHelper::appendStringArray(columns_[8], record.metadata_title);
+    JsonHelper::appendQuoted(columns_[9], record.metadata_type);
+    for (auto &column : columns_) {
+      column.push_back('\n');
+    }
+  }
+  rows_ += records.size();
+}
+
+void ColumnarSink::flush() {
+  if (rows_ == 0) {
+    return;
+  }
+
+  const fs::path staging = fs::path(dir_) / ("." + partName(next_part_) + ".tmp");
+  fs::remove_all(staging);
+  fs::create_directories(staging);
+  for (size_t i = 0; i < kColumnCount; ++i) {
+    FileSync::write((staging / (std::string(kColumns[i]) + ".jsonl")).string(),
+                    columns_[i], false);
+  }
+  // Files, then their directory, then the rename that publishes the group
+  FileSync::syncDirectory(staging.string());
+  fs::rename(staging, fs::path(dir_) / partName(next_part_));
+  FileSync::syncDirectory(dir_);
+
+  next_part_++;
+  rows_ = 0;
+  for (auto &column : columns_) {
+    column.clear();
+  }
+}
+
+void ColumnarSink::commitWatermark(const std::vector<std::string> &set_specs,
+                                   const std::string &day) {
+  watermarks_.advance(set_specs, day);
+}
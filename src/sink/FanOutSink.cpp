@@ -0,0 +1,60 @@
+/**
+ * @file FanOutSink.cpp
+ * @brief Record sink forwarding to several sinks in parallel implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/FanOutSink.h"
+#include "utils/Logger.h"
+#include <exception>
+#include <thread>
+
+FanOutSink::FanOutSink(std::vector<std::unique_ptr<RecordSink>> sinks)
+    : sinks_(std::move(sinks)) {}
+
+std::string FanOutSink::name() const {
+  std::string name;
+  for (const auto &sink : sinks_) {
+    name += (name.empty() ? "" : " + ") + sink->name();
+  }
+  return name;
+}
+
+void FanOutSink::forEach(const std::function<void(RecordSink &)> &call) {
+  std::vector<std::exception_ptr> errors(sinks_.size());
+  std::vector<std::thread> threads;
+  threads.reserve(sinks_.size());
+
+  for (size_t i = 0; i < sinks_.size(); ++i) {
+    threads.emplace_back([&, i] {
+      try {
+        call(*sinks_[i]);
+      } catch (const std::exception &e) {
+        spdlog::error("Sink {} failed: {}", sinks_[i]->name(), e.what());
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+void FanOutSink::writeBatch(const std::vector<Record> &records) {
+  forEach([&](RecordSink &sink) { sink.writeBatch(records); });
+}
+
+void FanOutSink::flush() {
+  forEach([](RecordSink &sink) { sink.flush(); });
+}
+
+void FanOutSink::commitWatermark(const std::vector<std::string> &set_specs,
+                                 const std::string &day) {
+  forEach([&](RecordSink &sink) { sink.commitWatermark(set_specs, day); });
+}
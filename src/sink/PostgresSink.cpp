@@ -0,0 +1,57 @@
+/**
+ * @file PostgresSink.cpp
+ * @brief Record sink writing to the metadata table implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/PostgresSink.h"
+#include "db/RecordTable.h"
+#include "utils/Logger.h"
+
+PostgresSink::PostgresSink(Database &db, std::string schema_name,
+                           std::string table_name, PartitionScheme scheme,
+                           ColumnProfile profile)
+    : db_(db), schema_(std::move(schema_name)), table_(std::move(table_name)),
+      scheme_(scheme), profile_(profile) {}
+
+std::string PostgresSink::name() const {
+  return "postgres " + schema_ + "." + table_;
+}
+
+void PostgresSink::writeBatch(const std::vector<Record> &records) {
+  const std::string target = schema_ + "." + table_;
+  const std::string staging = table_ + "_staging";
+  const std::string &columns = RecordTable::columns();
+
+  if (scheme_ != PartitionScheme::None) {
+    std::vector<std::string> datestamps;
+    datestamps.reserve(records.size());
+    for (const auto &record : records) {
+      datestamps.push_back(record.header_datestamp);
+    }
+    db_.ensurePartitions(schema_, table_, scheme_, datestamps);
+  }
+
+  encoder_.clear();
+  for (const auto &record : records) {
+    RecordTable::encode(encoder_, record, profile_);
+  }
+  encoder_.finish();
+
+  db_.execute("BEGIN");
+  try {
+    db_.execute("CREATE TEMP TABLE IF NOT EXISTS " + staging +
+                " ON COMMIT DELETE ROWS AS SELECT" + columns + " FROM " +
+                target + " WITH NO DATA");
+    db_.copyFrom("COPY " + staging + " (" + columns +
+                     ") FROM STDIN WITH (FORMAT binary)",
+                 encoder_.data());
+    db_.execute(RecordTable::mergeQuery(target, staging, scheme_));
+    db_.execute("COMMIT");
+  } catch (const std::exception &e) {
+    // The whole batch is rolled back and retried on the next run
+    spdlog::error("Error inserting batch into {}: {}", target, e.what());
+    db_.execute("ROLLBACK");
+    throw;
+  }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file SqliteSink.cpp
+ * @brief Record sink writing to a SQLite database implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/SqliteSink.h"
+#include "utils/JsonHelper.h"
+#include "utils/Logger.h"
+#include <stdexcept>
+
+namespace {
+
+constexpr const char *kSchema = R"(
+    CREATE TABLE IF NOT EXISTS records (
+        header_identifier TEXT PRIMARY KEY,
+        header_datestamp TEXT,
+        header_setSpecs TEXT,
+        metadata_creator TEXT,
+        metadata_date TEXT,
+        metadata_description TEXT,
+        metadata_identifier TEXT,
+        metadata_subject TEXT,
+        metadata_title TEXT,
+        metadata_type TEXT,
+        updated_at TEXT DEFAULT CURRENT_TIMESTAMP
+    );
+    CREATE INDEX IF NOT EXISTS records_datestamp ON records (header_datestamp);
+    CREATE TABLE IF NOT EXISTS watermarks (
+        set_spec TEXT PRIMARY KEY,
+        high_water TEXT NOT NULL
+    );
+)";
+
+constexpr const char *kUpsert = R"(
+    INSERT INTO records (
+        header_identifier, header_datestamp, header_setSpecs,
+        metadata_creator, metadata_date, metadata_description,
+        metadata_identifier, metadata_subject, metadata_title, metadata_type)
+    VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)
+    ON CONFLICT (header_identifier) DO UPDATE SET
+        header_datestamp = excluded.header_datestamp,
+        header_setSpecs = excluded.header_setSpecs,
+        metadata_creator = excluded.metadata_creator,
+        metadata_date = excluded.metadata_date,
+        metadata_description = excluded.metadata_description,
+        metadata_identifier = excluded.metadata_identifier,
+        metadata_subject = excluded.metadata_subject,
+        metadata_title = excluded.metadata_title,
+        metadata_type = excluded.metadata_type,
+        updated_at = CURRENT_TIMESTAMP
+)";
+
+constexpr const char *kWatermark = R"(
+    INSERT INTO watermarks (set_spec, high_water) VALUES (?1, ?2)
+    ON CONFLICT (set_spec) DO UPDATE SET
+        high_water = max(high_water, excluded.high_water)
+)";
+
+} // namespace
+
+SqliteSink::SqliteSink(std::string path)
+    : path_(std::move(path)), db_(nullptr), upsert_(nullptr),
+      watermark_(nullptr) {
+  if (sqlite3_open(path_.c_str(), &db_) != SQLITE_OK) {
+    std::string error = db_ ? sqlite3_errmsg(db_) : "out of memory";
+    sqlite3_close(db_);
+    throw std::runtime_error("Cannot open SQLite database " + path_ + ": " +
+                             error);
+  }
+
+  try {
+    // WAL lets readers query the file while the harvest writes to it. FULL
+    // syncs the WAL on every commit, so a flushed page survives a power
+    // loss before the ledger that follows it is committed in Postgres.
+    exec("PRAGMA journal_mode = WAL");
+    exec("PRAGMA synchronous = FULL");
+    exec(kSchema);
+    if (sqlite3_prepare_v2(db_, kUpsert, -1, &upsert_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db_, kWatermark, -1, &watermark_, nullptr) !=
+            SQLITE_OK) {
+      throw std::runtime_error(sqlite3_errmsg(db_));
+    }
+  } catch (...) {
+    sqlite3_finalize(upsert_);
+    sqlite3_finalize(watermark_);
+    sqlite3_close(db_);
+    throw;
+  }
+}
+
+SqliteSink::~SqliteSink() {
+  sqlite3_finalize(upsert_);
+  sqlite3_finalize(watermark_);
+  sqlite3_close(db_);
+}
+
+std::string SqliteSink::name() const { return "sqlite " + path_; }
+
+void SqliteSink::exec(const char *sql) {
+  char *error = nullptr;
+  if (sqlite3_exec(db_, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+    std::string message = error ? error : "unknown error";
+    sqlite3_free(error);
+    throw std::runtime_error("SQLite error in " + path_ + ": " + message);
+  }
+}
+
+void SqliteSink::writeBatch(const std::vector<Record> &records) {
+  auto bind = [&](int index, const std::string &value) {
+    sqlite3_bind_text(upsert_, index, value.data(),
+                      static_cast<int>(value.size()), SQLITE_TRANSIENT);
+  };
+
+  exec("BEGIN");
+  try {
+    for (const auto &record : records) {
+      bind(1, record.header_identifier);
+      bind(2, record.header_datestamp);
+      bind(3, JsonHelper::vectorToJson(record.header_setSpecs));
+      bind(4, JsonHelper::vectorToJson(record.metadata_creator));
+      bind(5, JsonHelper::vectorToJson(record.metadata_date));
+      bind(6, record.metadata_description);
+      bind(7, JsonHelper::vectorToJson(record.metadata_identifier));
+      bind(8, JsonHelper::vectorToJson(record.metadata_subject));
+      bind(9, JsonHelper::vectorToJson(record.metadata_title));
+      bind(10, record.metadata_type);
+
+      int rc = sqlite3_step(upsert_);
+      sqlite3_reset(upsert_);
+      if (rc != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db_));
+      }
+    }
+    exec("COMMIT");
+  } catch (const std::exception &e) {
+    spdlog::error("Error writing batch to {}: {}", path_, e.what());
+    exec("ROLLBACK");
+    throw;
+  }
+}
+
+void SqliteSink::commitWatermark(const std::vector<std::string> &set_specs,
+                                 const std::string &day) {
+  for (const auto &set_spec : set_specs) {
+    sqlite3_bind_text(watermark_, 1, set_spec.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(watermark_, 2, day.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(watermark_);
+    sqlite3_reset(watermark_);
+    if (rc != SQLITE_DONE) {
+      throw std::runtime_error("SQLite error in " + path_ + ": " +
+                               sqlite3_errmsg(db_));
+    }
+  }
+}
@@ -0,0 +1,53 @@
+/**
+ * @file WatermarkFile.cpp
+ * @brief Set high-water marks kept in a JSON file next to a file sink
+ * implementation
+ * @author Bernard Chase
+ */
+
+#include "sink/WatermarkFile.h"
+#include "utils/FileSync.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+WatermarkFile::WatermarkFile(std::string path) : path_(std::move(path)) {
+  std::ifstream in(path_);
+  if (!in.is_open()) {
+    return;
+  }
+  nlohmann::json marks = nlohmann::json::parse(in, nullptr, false);
+  if (marks.is_object()) {
+    for (auto it = marks.begin(); it != marks.end(); ++it) {
+      if (it.value().is_string()) {
+        marks_[it.key()] = it.value().get<std::string>();
+      }
+    }
+  }
+}
+
+void WatermarkFile::advance(const std::vector<std::string> &set_specs,
+                            const std::string &day) {
+  for (const auto &set_spec : set_specs) {
+    std::string &mark = marks_[set_spec];
+    mark = std::max(mark, day);
+  }
+
+  const std::filesystem::path parent =
+      std::filesystem::path(path_).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent);
+  }
+
+  // Synced file, rename, synced directory: the mark never reaches the disk
+  // ahead of the data the sink flushed before it
+  const std::string tmp = path_ + ".tmp";
+  FileSync::write(tmp, nlohmann::json(marks_).dump(2) + "\n", false);
+  if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+    throw std::runtime_error("Cannot replace " + path_);
+  }
+  FileSync::syncDirectory(parent.string());
+}
@@ -0,0 +1,38 @@
+/**
+ * @file FileSync.cpp
+ * @brief Durable file writes for the file-based record sinks implementation
+ * @author Bernard Chase
+ */
+
+#include "utils/FileSync.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+void FileSync::write(const std::string &path, const std::string &data,
+                     bool append) {
+  FILE *file = std::fopen(path.c_str(), append ? "ab" : "wb");
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path + " for writing");
+  }
+  bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() &&
+            std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok) {
+    throw std::runtime_error("Cannot write to " + path);
+  }
+}
+
+void FileSync::syncDirectory(const std::string &path) {
+  const std::string dir = path.empty() ? "." : path;
+  int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open directory " + dir);
+  }
+  bool ok = fsync(fd) == 0;
+  close(fd);
+  if (!ok) {
+    throw std::runtime_error("Cannot sync directory " + dir);
+  }
+}
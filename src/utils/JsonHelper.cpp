@@ -5,16 +5,183 @@
  */
 
 #include "utils/JsonHelper.h"
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using json = nlohmann::json;
 
+namespace {
+
+// True for bytes that cannot appear unescaped inside a JSON string
+inline bool needsEscape(unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Return the first byte in [p, end) that needs escaping, or end. Most
+// metadata strings contain none, so the scan dominates and runs 16 bytes
+// (SSE2) or 8 bytes (SWAR) at a time.
+const char *findEscape(const char *p, const char *end) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control_max = _mm_set1_epi8(0x1f);
+
+  while (end - p >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // Unsigned c <= 0x1f is max(c, 0x1f) == 0x1f
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+#else
+  constexpr uint64_t ones = 0x0101010101010101ULL;
+  constexpr uint64_t highs = 0x8080808080808080ULL;
+
+  while (end - p >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    uint64_t quotes = word ^ (ones * '"');
+    uint64_t backslashes = word ^ (ones * '\\');
+    // Any zero byte in quotes/backslashes, or any byte below 0x20 in word
+    uint64_t hits = ((quotes - ones) & ~quotes) |
+                    ((backslashes - ones) & ~backslashes) |
+                    ((word - ones * 0x20) & ~word);
+    if (hits & highs) {
+      break;
+    }
+    p += 8;
+  }
+#endif
+
+  while (p < end && !needsEscape(static_cast<unsigned char>(*p))) {
+    ++p;
+  }
+  return p;
+}
+
+} // namespace
+
+bool JsonHelper::mayBeJson(std::string_view str) {
+  auto isSpace = [](char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  };
+
+  size_t first = 0;
+  while (first < str.size() && isSpace(str[first])) {
+    ++first;
+  }
+  size_t last = str.size();
+  while (last > first && isSpace(str[last - 1])) {
+    --last;
+  }
+  if (first == last) {
+    return false;
+  }
+
+  // A JSON text opens with an object, array, string, number or literal and
+  // closes with the matching bracket, quote, digit or literal's last letter.
+  // Titles and abstracts almost always fail one of these two checks.
+  char head = str[first];
+  char tail = str[last - 1];
+  switch (head) {
+  case '{':
+    return tail == '}';
+  case '[':
+    return tail == ']';
+  case '"':
+    return tail == '"' && last - first >= 2;
+  case 't':
+  case 'n':
+  case 'f':
+    return tail == 'e' || tail == 'l';
+  default:
+    return (head == '-' || (head >= '0' && head <= '9')) && tail >= '0' &&
+           tail <= '9';
+  }
+}
+
 std::string JsonHelper::vectorToJson(const std::vector<std::string> &vec) {
-  json j = json::array();
+  std::string out;
+  appendStringArray(out, vec);
+  return out;
+}
+
+void JsonHelper::appendQuoted(std::string &out, std::string_view str) {
+  static const char hex[] = "0123456789abcdef";
+
+  out.push_back('"');
+
+  const char *p = str.data();
+  const char *end = p + str.size();
+  while (p < end) {
+    const char *special = findEscape(p, end);
+    out.append(p, special - p);
+    if (special == end) {
+      break;
+    }
+
+    unsigned char c = static_cast<unsigned char>(*special);
+    switch (c) {
+    case '"':
+      out.append("\\\"", 2);
+      break;
+    case '\\':
+      out.append("\\\\", 2);
+      break;
+    case '\b':
+      out.append("\\b", 2);
+      break;
+    case '\f':
+      out.append("\\f", 2);
+      break;
+    case '\n':
+      out.append("\\n", 2);
+      break;
+    case '\r':
+      out.append("\\r", 2);
+      break;
+    case '\t':
+      out.append("\\t", 2);
+      break;
+    default: {
+      char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+      out.append(escaped, sizeof(escaped));
+      break;
+    }
+    }
+    p = special + 1;
+  }
+
+  out.push_back('"');
+}
+
+void JsonHelper::appendStringArray(std::string &out,
+                                   const std::vector<std::string> &vec) {
+  size_t needed = 2 + vec.size() * 3;
   for (const auto &item : vec) {
-    j.push_back(item);
+    needed += item.size();
+  }
+  out.reserve(out.size() + needed);
+
+  out.push_back('[');
+  for (size_t i = 0; i < vec.size(); ++i) {
+    if (i > 0) {
+      out.push_back(',');
+    }
+    appendQuoted(out, vec[i]);
   }
-  return j.dump();
+  out.push_back(']');
 }
 
 std::vector<std::string> JsonHelper::jsonToVector(const std::string &json_str) {
@@ -41,15 +208,20 @@ std::string JsonHelper::safeSerialize(const std::string &str) {
     return "null";
   }
 
-  try {
-    // Try to parse as JSON first
-    json j = json::parse(str);
-    return j.dump();
-  } catch (...) {
-    // If not valid JSON, return as serialized string
-    json j = str;
-    return j.dump();
+  // Only text that looks like a JSON document is handed to the parser, and
+  // the parser reports failure by value rather than by exception
+  if (mayBeJson(str)) {
+    json j = json::parse(str, nullptr, /*allow_exceptions=*/false);
+    if (!j.is_discarded()) {
+      return j.dump();
+    }
   }
+
+  // Not valid JSON: serialize as a JSON string
+  std::string out;
+  out.reserve(str.size() + 2);
+  appendQuoted(out, str);
+  return out;
 }
 
 std::string JsonHelper::safeSerialize(const std::vector<std::string> &vec) {
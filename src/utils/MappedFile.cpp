@@ -0,0 +1,53 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Read-only memory map of a file implementation
+ * @author Bernard Chase
+ */
+
+#include "utils/MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + path + ": " +
+                             std::strerror(errno));
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    int error = errno;
+    ::close(fd);
+    throw std::runtime_error("Cannot stat " + path + ": " +
+                             std::strerror(error));
+  }
+
+  // mmap rejects empty mappings; an empty file is an empty view
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      int error = errno;
+      ::close(fd);
+      throw std::runtime_error("Cannot map " + path + ": " +
+                               std::strerror(error));
+    }
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(addr);
+  }
+
+  // The mapping keeps the file referenced
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
@@ -0,0 +1,184 @@
+/**
+ * @file JobQueueTest.cpp
+ * @brief Integration tests for the harvest_jobs queue against a local Postgres
+ * @author Bernard Chase
+ *
+ * Runs against the database in DATABASE_URL (a libpq connection string or
+ * postgresql:// URL) inside a throwaway schema; exits with 77, which ctest
+ * reports as skipped, when it is not set.
+ */
+
+#include "db/Database.h"
+#include "db/JobQueue.h"
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int kSkipped = 77;
+constexpr int kLease = 60;
+const std::string kRepository = "test";
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      throw std::runtime_error(std::string(__FILE__) + ":" +                   \
+                               std::to_string(__LINE__) + ": " #condition);    \
+    }                                                                          \
+  } while (0)
+
+struct Fixture {
+  Database &db;
+  JobQueue &queue;
+};
+
+std::string status(Database &db, const JobQueue &queue, long id) {
+  std::string job_id = std::to_string(id);
+  PGresult *res = db.query("SELECT status FROM " + queue.tableName() +
+                               " WHERE id = $1::bigint",
+                           {job_id.c_str()});
+  std::string value = PQntuples(res) > 0 ? PQgetvalue(res, 0, 0) : "";
+  PQclear(res);
+  return value;
+}
+
+// Pushes the lease into the past, as if its holder had died
+void expireLease(Database &db, const JobQueue &queue, long id) {
+  std::string job_id = std::to_string(id);
+  db.execute("UPDATE " + queue.tableName() +
+                 " SET lease_until = now() - interval '1 second' "
+                 "WHERE id = $1::bigint",
+             {job_id.c_str()});
+}
+
+void concurrentClaimsGetDifferentJobs(Fixture &f, JobQueue &other_queue) {
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-01", "2024-01-07"));
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-08", "2024-01-14"));
+
+  // The first claim's row stays locked until COMMIT; the second claim must
+  // skip it rather than wait for it or take it too
+  f.db.execute("BEGIN");
+  std::optional<HarvestJob> first = f.queue.claim(kRepository, "a", kLease, 3);
+  std::optional<HarvestJob> second =
+      other_queue.claim(kRepository, "b", kLease, 3);
+  f.db.execute("COMMIT");
+
+  CHECK(first && second);
+  CHECK(first->id != second->id);
+  CHECK(!f.queue.claim(kRepository, "c", kLease, 3));
+}
+
+void expiredLeaseIsReclaimed(Fixture &f) {
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-01", "2024-01-07"));
+  std::optional<HarvestJob> job = f.queue.claim(kRepository, "a", kLease, 3);
+  CHECK(job);
+  CHECK(!f.queue.claim(kRepository, "b", kLease, 3));
+
+  expireLease(f.db, f.queue, job->id);
+  std::optional<HarvestJob> reclaimed =
+      f.queue.claim(kRepository, "b", kLease, 3);
+  CHECK(reclaimed && reclaimed->id == job->id);
+  CHECK(reclaimed->attempts == 2);
+
+  // The old holder finds out on its next heartbeat
+  CHECK(!f.queue.heartbeat(job->id, "a", kLease));
+  CHECK(f.queue.heartbeat(job->id, "b", kLease));
+}
+
+void failReachesFailedAfterMaxAttempts(Fixture &f) {
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-01", "2024-01-07"));
+
+  std::optional<HarvestJob> job = f.queue.claim(kRepository, "a", kLease, 2);
+  CHECK(job);
+  f.queue.fail(job->id, "a", "first", 2);
+  CHECK(status(f.db, f.queue, job->id) == "pending");
+
+  job = f.queue.claim(kRepository, "a", kLease, 2);
+  CHECK(job && job->attempts == 2);
+  f.queue.fail(job->id, "a", "second", 2);
+  CHECK(status(f.db, f.queue, job->id) == "failed");
+  CHECK(!f.queue.claim(kRepository, "a", kLease, 2));
+}
+
+void releaseKeepsTheAttempt(Fixture &f) {
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-01", "2024-01-07"));
+
+  std::optional<HarvestJob> job = f.queue.claim(kRepository, "a", kLease, 1);
+  CHECK(job && job->attempts == 1);
+  f.queue.release(job->id, "a");
+  CHECK(status(f.db, f.queue, job->id) == "pending");
+
+  job = f.queue.claim(kRepository, "b", kLease, 1);
+  CHECK(job && job->attempts == 1);
+}
+
+void lostFinalAttemptFailsAndUnblocksEnqueue(Fixture &f) {
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-01", "2024-01-07"));
+
+  std::optional<HarvestJob> job = f.queue.claim(kRepository, "a", kLease, 1);
+  CHECK(job);
+  expireLease(f.db, f.queue, job->id);
+
+  CHECK(!f.queue.claim(kRepository, "b", kLease, 1));
+  CHECK(status(f.db, f.queue, job->id) == "failed");
+
+  // An overlapping window is no longer blocked by the dead job
+  CHECK(f.queue.enqueue(kRepository, "cs", "2024-01-05", "2024-01-10"));
+}
+
+} // namespace
+
+int main() {
+  const char *url = std::getenv("DATABASE_URL");
+  if (!url || !*url) {
+    std::cout << "DATABASE_URL not set; skipping job queue tests\n";
+    return kSkipped;
+  }
+
+  const std::string schema = "arhida_test_" + std::to_string(getpid());
+  Database db;
+  Database other_db;
+  db.connect(url);
+  other_db.connect(url);
+  db.execute("CREATE SCHEMA " + schema);
+
+  JobQueue queue(db);
+  JobQueue other_queue(other_db);
+  queue.ensureTable(schema);
+  other_queue.ensureTable(schema);
+  Fixture fixture{db, queue};
+
+  const std::vector<std::pair<std::string, std::function<void()>>> tests = {
+      {"concurrent claims get different jobs",
+       [&] { concurrentClaimsGetDifferentJobs(fixture, other_queue); }},
+      {"expired lease is reclaimed", [&] { expiredLeaseIsReclaimed(fixture); }},
+      {"fail reaches failed after max attempts",
+       [&] { failReachesFailedAfterMaxAttempts(fixture); }},
+      {"release keeps the attempt", [&] { releaseKeepsTheAttempt(fixture); }},
+      {"lost final attempt fails and unblocks enqueue",
+       [&] { lostFinalAttemptFailsAndUnblocksEnqueue(fixture); }},
+  };
+
+  int failures = 0;
+  for (const auto &[name, test] : tests) {
+    // Every test starts from an empty queue
+    db.execute("TRUNCATE " + queue.tableName());
+    try {
+      test();
+      std::cout << "PASS " << name << "\n";
+    } catch (const std::exception &e) {
+      std::cout << "FAIL " << name << ": " << e.what() << "\n";
+      failures++;
+    }
+  }
+
+  db.execute("DROP SCHEMA " + schema + " CASCADE");
+  return failures == 0 ? 0 : 1;
+}